@@ -5,6 +5,7 @@
 #include <QThread>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QWaitCondition>
 #include <QSharedPointer>
 #include <QScopedPointer>
 #include <QPointer>
@@ -13,12 +14,22 @@
 #include <QtMath>
 #include <QDebug>
 #include <QAtomicInt>
+#include <QAtomicPointer>
 #include <QRandomGenerator>
 #include <QElapsedTimer>
+#include <QDeadlineTimer>
+#include <QVarLengthArray>
+#include <QHash>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QFuture>
+#include <QPromise>
 #include <limits>
 #include <cmath>
 #include <algorithm>
 #include <cstring>
+#include <type_traits>
+#include <functional>
 
 #define EPSS 1e-6
 #define MULTI_THREAD_REBUILD_POINT_NUM 1500
@@ -27,6 +38,20 @@
 #define ForceRebuildPercentage 0.2
 #define Q_LEN 1000000
 
+// 遍历软件预取距离：0关闭；1在确定访问顺序后预取子节点；N>1时每次出栈再预取栈中第N-1个待访问子树
+#ifndef IKD_TREE_PREFETCH_DISTANCE
+#define IKD_TREE_PREFETCH_DISTANCE 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define IKD_TREE_PREFETCH(address) __builtin_prefetch(address)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define IKD_TREE_PREFETCH(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+#else
+#define IKD_TREE_PREFETCH(address) ((void)(address))
+#endif
+
 /*
 Description: ikd-Tree: an incremental k-d tree for robotic applications - Qt版本头文件实现
 Author: Yixi Cai (原作者) + Qt移植版本
@@ -183,11 +208,14 @@ public:
  * 
  * 使用Qt风格的模板化3D点数据结构，支持自定义数据类型
  * @tparam DataType 附加数据成员的类型，默认为int
+ * @tparam Scalar 坐标标量类型，默认为double；毫米级精度的场景可使用float减半内存
  */
-template<typename DataType = int>
+template<typename DataType = int, typename Scalar = double>
 struct ikdTree_PointType
 {
-    double x, y, z;      ///< 3D坐标，使用double类型提高精度
+    using ScalarType = Scalar;  ///< 坐标标量类型
+    
+    Scalar x, y, z;      ///< 3D坐标
     DataType data;       ///< 用户自定义的附加数据成员
     
     /**
@@ -205,7 +233,7 @@ struct ikdTree_PointType
      * @param d 附加数据值，默认为DataType的默认值
      */
     ikdTree_PointType(double px, double py, double pz, const DataType& d = DataType{})
-        : x(px), y(py), z(pz), data(d)
+        : x(static_cast<Scalar>(px)), y(static_cast<Scalar>(py)), z(static_cast<Scalar>(pz)), data(d)
     {
     }
     
@@ -215,7 +243,7 @@ struct ikdTree_PointType
      * @param d 附加数据值，默认为DataType的默认值
      */
     explicit ikdTree_PointType(const Vector3D& vec, const DataType& d = DataType{})
-        : x(vec.x()), y(vec.y()), z(vec.z()), data(d)
+        : x(static_cast<Scalar>(vec.x())), y(static_cast<Scalar>(vec.y())), z(static_cast<Scalar>(vec.z())), data(d)
     {
     }
     
@@ -236,32 +264,36 @@ struct ikdTree_PointType
      * @param d 附加数据值，默认为DataType的默认值
      */
     ikdTree_PointType(float px, float py, float pz, const DataType& d = DataType{})
-        : x(static_cast<double>(px)), y(static_cast<double>(py)), z(static_cast<double>(pz)), data(d)
+        : x(static_cast<Scalar>(px)), y(static_cast<Scalar>(py)), z(static_cast<Scalar>(pz)), data(d)
     {
     }
 };
 
 // 为了兼容性，提供默认的点类型别名
 using DefaultPointType = ikdTree_PointType<int>;
+using FloatPointType = ikdTree_PointType<int, float>;   ///< 单精度坐标点类型
+using PointId = quint32;                                ///< 稳定点编号类型
 
 /**
- * @brief 定义包围盒类型结构
+ * @brief 定义包围盒类型模板结构
  * 
  * 用于表示3D空间中的轴对齐包围盒
+ * @tparam Scalar 顶点坐标标量类型，与点类型的坐标类型一致
  */
-struct BoxPointType
+template<typename Scalar = double>
+struct ikdTree_BoxType
 {
-    double vertex_min[3];  ///< 包围盒最小顶点坐标 [x_min, y_min, z_min] (改为double)
-    double vertex_max[3];  ///< 包围盒最大顶点坐标 [x_max, y_max, z_max] (改为double)
+    Scalar vertex_min[3];  ///< 包围盒最小顶点坐标 [x_min, y_min, z_min]
+    Scalar vertex_max[3];  ///< 包围盒最大顶点坐标 [x_max, y_max, z_max]
     
     /**
      * @brief 默认构造函数 - 初始化包围盒
      */
-    BoxPointType() 
+    ikdTree_BoxType() 
     {
         for(int i = 0; i < 3; ++i) {
-            vertex_min[i] = 0.0;
-            vertex_max[i] = 0.0;
+            vertex_min[i] = 0;
+            vertex_max[i] = 0;
         }
     }
     
@@ -270,8 +302,8 @@ struct BoxPointType
      * @param min_point 最小点坐标
      * @param max_point 最大点坐标
      */
-    template<typename DataType>
-    BoxPointType(const ikdTree_PointType<DataType>& min_point, const ikdTree_PointType<DataType>& max_point)
+    template<typename DataType, typename PointScalar>
+    ikdTree_BoxType(const ikdTree_PointType<DataType, PointScalar>& min_point, const ikdTree_PointType<DataType, PointScalar>& max_point)
     {
         vertex_min[0] = min_point.x; vertex_min[1] = min_point.y; vertex_min[2] = min_point.z;
         vertex_max[0] = max_point.x; vertex_max[1] = max_point.y; vertex_max[2] = max_point.z;
@@ -282,15 +314,17 @@ struct BoxPointType
      * @param min_vals 最小值数组[3]
      * @param max_vals 最大值数组[3]
      */
-    BoxPointType(const float min_vals[3], const float max_vals[3])
+    ikdTree_BoxType(const float min_vals[3], const float max_vals[3])
     {
         for(int i = 0; i < 3; ++i) {
-            vertex_min[i] = static_cast<double>(min_vals[i]);
-            vertex_max[i] = static_cast<double>(max_vals[i]);
+            vertex_min[i] = static_cast<Scalar>(min_vals[i]);
+            vertex_max[i] = static_cast<Scalar>(max_vals[i]);
         }
     }
 };
 
+using BoxPointType = ikdTree_BoxType<double>;    ///< 默认双精度包围盒类型
+
 enum operation_set {ADD_POINT, DELETE_POINT, DELETE_BOX, ADD_BOX, DOWNSAMPLE_DELETE, PUSH_DOWN};
 
 enum delete_point_storage_set {NOT_RECORD, DELETE_POINTS_REC, MULTI_THREAD_REC};
@@ -314,12 +348,11 @@ private:
 
 public:
     /**
-     * @brief 构造函数 - 初始化队列
+     * @brief 构造函数 - 初始化队列，存储在第一次push时才分配
      */
     explicit MANUAL_Q() 
         : m_head(0), m_tail(0), m_counter(0), m_isEmpty(true)
     {
-        m_queue.resize(Q_LEN);
     }
     
     /**
@@ -342,6 +375,7 @@ public:
     T front() const
     {
         QMutexLocker locker(&m_mutex);
+        if (m_queue.isEmpty()) return T();
         return m_queue[m_head];
     }
     
@@ -352,6 +386,7 @@ public:
     T back() const
     {
         QMutexLocker locker(&m_mutex);
+        if (m_queue.isEmpty()) return T();
         return m_queue[m_tail];
     }
     
@@ -374,6 +409,7 @@ public:
     void push(const T& op)
     {
         QMutexLocker locker(&m_mutex);
+        if (m_queue.isEmpty()) m_queue.resize(Q_LEN);
         m_queue[m_tail] = op;
         m_counter++;
         if (m_isEmpty) m_isEmpty = false;
@@ -403,44 +439,407 @@ public:
 };
 
 /**
- * @brief 增量式K-D树类模板 - Qt版本实现
+ * @brief 空队列类模板 - 与MANUAL_Q接口一致但不分配任何存储
+ *
+ * 单线程策略下替代操作日志队列，所有操作均为空操作
+ * @tparam T 队列元素类型
+ */
+template <typename T>
+class NULL_Q
+{
+public:
+    void pop() {}
+    T front() const { return T(); }
+    T back() const { return T(); }
+    void clear() {}
+    void push(const T&) {}
+    bool empty() const { return true; }
+    int size() const { return 0; }
+};
+
+/**
+ * @brief 空互斥锁 - 与QMutex接口一致但不做任何同步
+ *
+ * 单线程策略下替代QMutex，可直接配合QMutexLocker使用
+ */
+class NullMutex
+{
+public:
+    void lock() {}
+    void unlock() {}
+    bool tryLock() { return true; }
+};
+
+/**
+ * @brief 空读写锁 - 与RegionReadWriteLock接口一致但不做任何同步
+ */
+class NullReadWriteLock
+{
+public:
+    void lockForRead() {}
+    void lockForWrite() {}
+    bool lockForRegion() { return true; }
+    void openRegion() {}
+    bool releaseRegion() { return true; }
+    void unlock() {}
+};
+
+/**
+ * @brief 空读写锁守卫 - 单线程策略下替代RegionReadWriteLocker
+ */
+class NullReadWriteLocker
+{
+public:
+    explicit NullReadWriteLocker(NullReadWriteLock*) {}
+    void unlock() {}
+    void relock() {}
+};
+
+/**
+ * @brief 区域读写锁 - 在QReadWriteLock的读、写模式之外增加区域写模式
  * 
- * 支持动态插入、删除和搜索的高效3D点云数据结构
+ * 读模式之间共享，区域写模式之间共享，读与区域写互斥，写模式独占。区域写会话由第一个进入者打开，
+ * 打开者做完准备工作并调用openRegion()后其余区域写者才能加入；离开时releaseRegion()返回true的
+ * 是最后一个区域写者，它在会话仍然关闭的状态下完成收尾，再调用unlock()。
+ * 按阶段公平轮换：有其他模式的等待者时不再接纳同模式的新进入者；一个阶段结束时把下一阶段交给
+ * 此刻正在等待的另一方（全部等待的读者或区域写者，或一个写者），刚释放的线程不能立即抢回
+ */
+class RegionReadWriteLock
+{
+public:
+    void lockForRead() { lock(READ); }
+    void lockForWrite() { lock(WRITE); }
+    
+    /**
+     * @brief 以区域写模式加锁
+     * @return 是否为会话打开者；打开者须在准备完成后调用openRegion()
+     */
+    bool lockForRegion() { return lock(REGION); }
+    
+    /**
+     * @brief 打开区域写会话，允许其余区域写者加入
+     */
+    void openRegion()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_closed = false;
+        m_condition.wakeAll();
+    }
+    
+    /**
+     * @brief 离开区域写会话
+     * @return 是否为最后一个区域写者；为true时会话保持关闭，收尾后须再调用unlock()
+     */
+    bool releaseRegion()
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_holders == 1) {
+            m_closed = true;
+            return true;
+        }
+        m_holders--;
+        return false;
+    }
+    
+    void unlock()
+    {
+        QMutexLocker locker(&m_mutex);
+        if (--m_holders > 0) return;
+        // 阶段结束：交给等待中的另一方
+        if (m_mode != READ && m_waiting[READ] > 0) {
+            m_handoffMode = READ;
+            m_handoff = m_waiting[READ];
+        } else if (m_mode == READ && m_waiting[WRITE] > 0) {
+            m_handoffMode = WRITE;
+            m_handoff = 1;
+        } else if (m_mode == READ && m_waiting[REGION] > 0) {
+            m_handoffMode = REGION;
+            m_handoff = m_waiting[REGION];
+        }
+        m_mode = NONE;
+        m_condition.wakeAll();
+    }
+    
+private:
+    enum Mode { READ, WRITE, REGION, NONE };
+    
+    bool lock(Mode mode)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_waiting[mode]++;
+        while (!admits(mode)) m_condition.wait(&m_mutex);
+        m_waiting[mode]--;
+        if (m_handoff > 0 && mode == m_handoffMode) m_handoff--;
+        const bool opened = m_holders == 0;
+        if (opened) {
+            m_mode = mode;
+            m_closed = mode == REGION;
+        }
+        m_holders++;
+        return opened;
+    }
+    
+    bool admits(Mode mode) const
+    {
+        if (m_handoff > 0) {
+            if (mode != m_handoffMode) return false;
+            return m_holders == 0 || (mode != WRITE && !m_closed);
+        }
+        if (m_holders == 0) return true;
+        if (mode != m_mode || mode == WRITE) return false;
+        if (mode == READ) return m_waiting[WRITE] == 0 && m_waiting[REGION] == 0;
+        return !m_closed && m_waiting[WRITE] == 0 && m_waiting[READ] == 0;
+    }
+    
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    Mode m_mode = NONE;         ///< 当前持有模式
+    int m_holders = 0;          ///< 当前持有者数量
+    int m_waiting[3] = {0, 0, 0}; ///< 各模式的等待者数量
+    bool m_closed = false;      ///< 区域写会话是否拒绝新加入者
+    Mode m_handoffMode = NONE;  ///< 上一阶段结束时指定的下一阶段模式
+    int m_handoff = 0;          ///< 下一阶段尚待接纳的等待者数量
+};
+
+/**
+ * @brief 区域读写锁守卫 - 与QReadLocker/QWriteLocker用法一致
+ * @tparam Exclusive true为写锁，false为读锁
+ */
+template<bool Exclusive>
+class RegionReadWriteLocker
+{
+public:
+    explicit RegionReadWriteLocker(RegionReadWriteLock* lock) : m_lock(lock) { relock(); }
+    ~RegionReadWriteLocker() { unlock(); }
+    RegionReadWriteLocker(const RegionReadWriteLocker&) = delete;
+    RegionReadWriteLocker& operator=(const RegionReadWriteLocker&) = delete;
+    
+    void unlock()
+    {
+        if (!m_locked) return;
+        m_lock->unlock();
+        m_locked = false;
+    }
+    
+    void relock()
+    {
+        if (m_locked) return;
+        if (Exclusive) m_lock->lockForWrite();
+        else m_lock->lockForRead();
+        m_locked = true;
+    }
+    
+private:
+    RegionReadWriteLock* m_lock;
+    bool m_locked = false;
+};
+
+/**
+ * @brief 多线程策略（默认） - 启用后台重建、操作日志和全部互斥锁
+ */
+struct MultiThreaded
+{
+    static constexpr bool kMultiThread = true;
+    using Mutex = QMutex;
+    using ReadWriteLock = RegionReadWriteLock;
+    using ReadLocker = RegionReadWriteLocker<false>;
+    using WriteLocker = RegionReadWriteLocker<true>;
+    template <typename T> using OperationQueue = MANUAL_Q<T>;
+};
+
+/**
+ * @brief 单线程策略 - 编译期移除后台重建、操作日志和全部互斥锁
+ *
+ * 适用于离线建图、每线程独立的局部树等从不并发访问的场景，
+ * 所有重建在调用线程内同步完成
+ */
+struct SingleThreaded
+{
+    static constexpr bool kMultiThread = false;
+    using Mutex = NullMutex;
+    using ReadWriteLock = NullReadWriteLock;
+    using ReadLocker = NullReadWriteLocker;
+    using WriteLocker = NullReadWriteLocker;
+    template <typename T> using OperationQueue = NULL_Q<T>;
+};
+
+/**
+ * @brief 进程级重建执行器 - 所有MultiThreaded树的后台重建共用的线程池
+ *
+ * 线程池在第一次提交重建任务时才创建，线程在空闲一段时间后由QThreadPool回收，构造树不创建线程。
+ * 工作线程数为0时不做后台重建，所有重建在修改线程内同步完成
+ */
+class KD_TREE_REBUILD_EXECUTOR
+{
+public:
+    static constexpr int DEFAULT_WORKER_COUNT = 2;     ///< 默认工作线程数
+    
+    /**
+     * @brief 设置工作线程数，对之后提交的任务生效；0表示关闭后台重建
+     */
+    static void setWorkerCount(int workerCount)
+    {
+        EXECUTOR_STATE& executor = state();
+        QMutexLocker locker(&executor.mutex);
+        executor.workerCount = qMax(0, workerCount);
+        if (executor.pool) executor.pool->setMaxThreadCount(qMax(1, executor.workerCount));
+    }
+    
+    /**
+     * @brief 工作线程数
+     */
+    static int workerCount()
+    {
+        EXECUTOR_STATE& executor = state();
+        QMutexLocker locker(&executor.mutex);
+        return executor.workerCount;
+    }
+    
+    /**
+     * @brief 线程池是否已创建
+     */
+    static bool isStarted()
+    {
+        EXECUTOR_STATE& executor = state();
+        QMutexLocker locker(&executor.mutex);
+        return !executor.pool.isNull();
+    }
+    
+    /**
+     * @brief 提交任务，第一次提交时创建线程池
+     * @return 工作线程数为0时不接受任务，返回false
+     */
+    static bool submit(const std::function<void()>& task)
+    {
+        EXECUTOR_STATE& executor = state();
+        QMutexLocker locker(&executor.mutex);
+        if (executor.workerCount == 0) return false;
+        if (!executor.pool) {
+            executor.pool.reset(new QThreadPool());
+            executor.pool->setMaxThreadCount(executor.workerCount);
+        }
+        executor.pool->start(task);
+        return true;
+    }
+    
+private:
+    /**
+     * @brief 执行器状态 - 函数内静态对象，首次使用时构造
+     */
+    struct EXECUTOR_STATE
+    {
+        QMutex mutex;                           ///< 保护以下成员
+        int workerCount = DEFAULT_WORKER_COUNT; ///< 工作线程数
+        QScopedPointer<QThreadPool> pool;       ///< 线程池，首次提交时创建
+    };
+    
+    static EXECUTOR_STATE& state()
+    {
+        static EXECUTOR_STATE executor;
+        return executor;
+    }
+};
+
+/**
+ * @brief 增量式K-D树类模板 - Qt版本实现
+ *
+ * 支持动态插入、删除和搜索的高效3D点云数据结构。
+ *
+ * 并发约定（MultiThreaded）：单写多读。查询（nearestSearch、nearestSearchBatch、radiusSearch、boxSearch
+ * 及size()等const方法）可由任意多个线程同时调用，修改树的方法（build、addPoints、各删除/恢复方法及参数设置）
+ * 彼此互斥，二者以读写锁隔离，查询看到的总是某次修改完成前或完成后的完整状态。查询不下推删除标记、不写节点，
+ * 结果堆和遍历栈都是调用内的局部状态；树对象中不存在查询共享的缓冲区。
+ * 设置setWriterPartitionDepth()后，addPoints、deletePoints和deletePointBoxes之间按分区锁并发，仍与查询互斥。
+ * 需要在一组查询期间看到固定状态的线程可用snapshot()取只读快照，快照与树共享未被修改的节点块。
+ * 较大子树的重建提交到进程级的KD_TREE_REBUILD_EXECUTOR，重建任务展平子树时持有读锁，仅在替换子树时持有写锁。
+ * SingleThreaded策略下不加锁，同一实例不能被多个线程并发访问
  * @tparam PointType 点类型，通常为ikdTree_PointType<DataType>
+ * @tparam ThreadPolicy 线程策略，MultiThreaded（默认）或SingleThreaded
  */
-template<typename PointType>
+template<typename PointType, typename ThreadPolicy = MultiThreaded>
 class KD_TREE
 {
 public:
     using PointVector = QVector<PointType>;          ///< 点向量类型定义
-    using Ptr = QSharedPointer<KD_TREE<PointType>>; ///< 智能指针类型定义
+    using Ptr = QSharedPointer<KD_TREE<PointType, ThreadPolicy>>; ///< 智能指针类型定义
+    using ConstPtr = QSharedPointer<const KD_TREE<PointType, ThreadPolicy>>; ///< 只读智能指针类型，snapshot()的返回类型
+    using Mutex = typename ThreadPolicy::Mutex;     ///< 策略决定的互斥锁类型
+    using ReadWriteLock = typename ThreadPolicy::ReadWriteLock; ///< 策略决定的读写锁类型
+    using ReadLocker = typename ThreadPolicy::ReadLocker;       ///< 读锁守卫
+    using WriteLocker = typename ThreadPolicy::WriteLocker;     ///< 写锁守卫
+    using Scalar = std::remove_cv_t<decltype(PointType::x)>; ///< 坐标标量类型，决定节点包围盒与距离计算精度
+    using BoxType = ikdTree_BoxType<Scalar>;        ///< 与坐标精度一致的包围盒类型
+    
+    using NodeIndex = quint32;                      ///< 节点索引类型，指向节点内存池中的槽位
+    static constexpr NodeIndex NULL_NODE = 0;       ///< 空节点索引，内存池从不分配0号槽位
     
     /**
-     * @brief K-D树节点结构体 - 使用Qt内存管理
+     * @brief 近似K近邻参数 - 默认值即精确搜索
+     * 
+     * 子树下界乘以(1+epsilon)仍不小于当前第k近距离时剪枝，返回的第i近距离不超过真实值的(1+epsilon)倍；
+     * maxVisitedNodes限制单个查询进入的节点数，用尽后返回已找到的结果
      */
-    struct KD_TREE_NODE
+    struct APPROXIMATE_SEARCH
     {
-        PointType point;                        ///< 节点存储的点数据
+        double epsilon = 0.0;       ///< 剪枝放宽因子，0为精确
+        int maxVisitedNodes = 0;    ///< 进入节点数上限，0表示不限
+        
+        /**
+         * @brief 作用于距离平方的剪枝倍率(1+epsilon)^2
+         */
+        double pruneScale() const { return (1.0 + qMax(0.0, epsilon)) * (1.0 + qMax(0.0, epsilon)); }
+        
+        /**
+         * @brief 进入节点数上限，不限时为int最大值
+         */
+        int visitBudget() const { return maxVisitedNodes > 0 ? maxVisitedNodes : std::numeric_limits<int>::max(); }
+    };
+    
+    /**
+     * @brief 查询时限 - 截止时刻或进入节点数上限先到者生效，默认不限
+     * 
+     * 截止时刻每进入SEARCH_DEADLINE_CHECK_INTERVAL个节点检查一次，不包括等待读锁的时间
+     */
+    struct SEARCH_LIMIT
+    {
+        QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever); ///< 截止时刻
+        int maxVisitedNodes = 0;    ///< 进入节点数上限，0表示不限
+    };
+    
+    /**
+     * @brief K-D树节点结构体 - 按访问冷热分区并按缓存行对齐
+     * 
+     * 节点之间以32位内存池索引相连，子树不依赖绝对地址，快照因此可与原树共享同一批节点块。
+     * 双精度节点仍补齐为128字节，索引省下的字节不减少每点内存。第一条缓存行存放包围盒、
+     * 子节点索引以及分割轴和删除/下推标志，搜索剪枝只触及这一行；第二条缓存行
+     * 存放点数据，其后为仅在插入、删除和重建路径上访问的统计信息。
+     * 包围球半径由包围盒即时计算，根节点平衡因子保存在树对象中。
+     * 单精度坐标下节点约76字节，按16字节对齐紧凑存放比补齐到两条缓存行更快。
+     */
+    static constexpr size_t NODE_ALIGNMENT = sizeof(Scalar) >= sizeof(double) ? 64 : 16;
+    
+    struct alignas(NODE_ALIGNMENT) KD_TREE_NODE
+    {
+        // 热数据：遍历剪枝
+        Scalar node_range_x[2], node_range_y[2], node_range_z[2]; ///< 节点包围盒范围
+        NodeIndex left_son_idx = NULL_NODE;     ///< 左子节点索引
+        NodeIndex right_son_idx = NULL_NODE;    ///< 右子节点索引
         quint8 division_axis;                   ///< 分割轴 (0=x, 1=y, 2=z)
-        int TreeSize = 1;                       ///< 子树大小
-        int invalid_point_num = 0;              ///< 无效点数量
-        int down_del_num = 0;                   ///< 下采样删除点数量
         bool point_deleted = false;             ///< 点删除标志
         bool tree_deleted = false;              ///< 子树删除标志
+        bool need_push_down_to_left = false;    ///< 需要向左子树推送标志
+        bool need_push_down_to_right = false;   ///< 需要向右子树推送标志
         bool point_downsample_deleted = false;  ///< 点下采样删除标志
         bool tree_downsample_deleted = false;   ///< 子树下采样删除标志
-        bool need_push_down_to_left = false;    ///< 需要向左子树推送标志
-        bool need_push_down_to_right = false;   ///< 需要向右子树推送标志  
         bool working_flag = false;              ///< 工作状态标志
-        double radius_sq;                       ///< 节点包围球半径平方 (改为double)
-        QMutex push_down_mutex;                 ///< 推送操作互斥锁
-        double node_range_x[2], node_range_y[2], node_range_z[2]; ///< 节点包围盒范围 (改为double)
-        KD_TREE_NODE* left_son_ptr = nullptr;   ///< 左子节点指针
-        KD_TREE_NODE* right_son_ptr = nullptr;  ///< 右子节点指针
-        KD_TREE_NODE* father_ptr = nullptr;     ///< 父节点指针
-        // 用于论文数据记录
-        double alpha_del;                       ///< 删除平衡因子 (改为double)
-        double alpha_bal;                       ///< 结构平衡因子 (改为double)
+        // 访问节点自身
+        quint32 leaf_idx = 0;                   ///< 叶块索引，0表示普通单点节点
+        PointType point;                        ///< 节点存储的点数据
+        // 冷数据：更新与重建簿记
+        NodeIndex father_idx = NULL_NODE;       ///< 父节点索引
+        int TreeSize = 1;                       ///< 子树大小
+        int invalid_point_num = 0;              ///< 无效点数量
+        int down_del_num = 0;                   ///< 下采样删除点数量
         
         /**
          * @brief 默认构造函数 - 初始化节点
@@ -459,7 +858,7 @@ public:
     struct Operation_Logger_Type
     {
         PointType point;
-        BoxPointType boxpoint;
+        BoxType boxpoint;
         bool tree_deleted = false;
         bool tree_downsample_deleted = false;
         operation_set op;
@@ -556,1745 +955,5442 @@ public:
         }
     };    
 
-private:
-    // 多线程重建相关 - 使用Qt线程机制
-    QAtomicInt m_terminationFlag;               ///< 终止标志（原子操作）
-    QAtomicInt m_rebuildFlag;                   ///< 重建标志（原子操作）
-    QScopedPointer<QThread> m_rebuildThread;    ///< 重建线程智能指针
-    mutable QMutex m_terminationFlagMutex;      ///< 终止标志互斥锁
-    mutable QMutex m_rebuildPtrMutex;           ///< 重建指针互斥锁
-    mutable QMutex m_workingFlagMutex;          ///< 工作标志互斥锁
-    mutable QMutex m_searchFlagMutex;           ///< 搜索标志互斥锁
-    mutable QMutex m_rebuildLoggerMutex;        ///< 重建日志互斥锁
-    mutable QMutex m_pointsDeletedRebuildMutex; ///< 删除点重建互斥锁
-    MANUAL_Q<Operation_Logger_Type> m_rebuildLogger; ///< 重建操作日志队列
-    PointVector m_rebuildPclStorage;            ///< 重建点云存储
-    KD_TREE_NODE** m_rebuildPtr = nullptr;      ///< 重建指针
-    QAtomicInt m_searchMutexCounter;            ///< 搜索互斥计数器
+    /**
+     * @brief 遍历栈预分配深度 - 平衡树深度远小于此值，失衡子树超出时转为堆分配
+     * 
+     * 出栈时按字段逐个读取栈顶：入栈按字段分别写入，整帧一次读取无法从写缓冲转发，每次出栈都会停顿
+     */
+    static constexpr int TRAVERSAL_STACK_PREALLOC = 64;
     
-    // K-D树函数和增强变量 - Qt风格命名
-    int m_treesizeTemp = 0;                     ///< 临时树大小
-    int m_validnumTemp = 0;                     ///< 临时有效节点数
-    double m_alphaBalTemp = 0.5;                ///< 临时平衡因子 (改为double)
-    double m_alphaDelTemp = 0.0;                ///< 临时删除因子 (改为double)
-    double m_deleteCriterionParam = 0.5;        ///< 删除判据参数 (改为double)
-    double m_balanceCriterionParam = 0.7;       ///< 平衡判据参数 (改为double)
-    double m_downsampleSize = 0.2;              ///< 下采样尺寸 (改为double)
-    bool m_deleteStorageDisabled = false;       ///< 删除存储禁用标志
-    KD_TREE_NODE* m_staticRootNode = nullptr;   ///< 静态根节点指针
-    PointVector m_pointsDeleted;                ///< 已删除点集合
-    PointVector m_downsampleStorage;            ///< 下采样存储
-    PointVector m_multithreadPointsDeleted;     ///< 多线程删除点集合
-
-    // 私有方法实现（header-only模板设计，无需声明）
+    template<typename Frame>
+    using TraversalStack = QVarLengthArray<Frame, TRAVERSAL_STACK_PREALLOC>;
     
     /**
-     * @brief 多线程重建处理函数实现 - Qt版本
+     * @brief 截止时刻的检查间隔（进入的节点数）
      */
-    void multiThreadRebuild() {
-        bool terminated = false;
-        KD_TREE_NODE* fatherPtr;
-        KD_TREE_NODE** newNodePtr;
-        Q_UNUSED(newNodePtr);
-        
-        while (!terminated) {
-            {
-                QMutexLocker terminationLocker(&m_terminationFlagMutex);
-                terminated = m_terminationFlag.loadRelaxed();
-            }
-            
-            if (terminated) break;
-            
-            {
-                QMutexLocker rebuildLocker(&m_rebuildPtrMutex);
-                QMutexLocker workingLocker(&m_workingFlagMutex);
-                
-                if (m_rebuildPtr != nullptr) {
-                    // 执行重建逻辑
-                    if (!m_rebuildLogger.empty()) {
-                        qDebug() << u8"警告: 重建日志队列非空!";
-                    }
-                    
-                    m_rebuildFlag.storeRelaxed(1);
-                    if (*m_rebuildPtr == m_rootNode) {
-                        m_treesizeTemp = m_rootNode->TreeSize;
-                        m_validnumTemp = m_rootNode->TreeSize - m_rootNode->invalid_point_num;
-                        m_alphaBalTemp = m_rootNode->alpha_bal;
-                        m_alphaDelTemp = m_rootNode->alpha_del;
-                    }
-                    
-                    KD_TREE_NODE* oldRootNode = (*m_rebuildPtr);
-                    fatherPtr = (*m_rebuildPtr)->father_ptr;
-                    m_rebuildPclStorage.clear();
-                    
-                    // 锁定搜索
-                    {
-                        QMutexLocker searchLocker(&m_searchFlagMutex);
-                        while (m_searchMutexCounter.loadRelaxed() != 0) {
-                            searchLocker.unlock();
-                            QThread::usleep(1);
-                            searchLocker.relock();
-                        }
-                        m_searchMutexCounter.storeRelaxed(-1);
-                    }
-                    
-                    // 锁定删除点缓存并展平树
-                    {
-                        QMutexLocker pointsLocker(&m_pointsDeletedRebuildMutex);
-                        flatten(*m_rebuildPtr, m_rebuildPclStorage, MULTI_THREAD_REC);
-                    }
-                    
-                    // 解锁搜索
-                    {
-                        QMutexLocker searchLocker(&m_searchFlagMutex);
-                        m_searchMutexCounter.storeRelaxed(0);
-                    }
-                    
-                    workingLocker.unlock();
-                    
-                    // 重建和更新遗漏的操作
-                    Operation_Logger_Type operation;
-                    KD_TREE_NODE* newRootNode = nullptr;
-                    
-                    if (m_rebuildPclStorage.size() > 0) {
-                        buildTree(&newRootNode, 0, m_rebuildPclStorage.size()-1, m_rebuildPclStorage);
-                        
-                        // 处理重建期间积累的操作
-                        workingLocker.relock();
-                        {
-                            QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                            int tmpCounter = 0;
-                            while (!m_rebuildLogger.empty()) {
-                                operation = m_rebuildLogger.front();
-                                m_maxQueueSize = qMax(m_maxQueueSize, m_rebuildLogger.size());
-                                m_rebuildLogger.pop();
-                                loggerLocker.unlock();
-                                workingLocker.unlock();
-                                runOperation(&newRootNode, operation);
-                                tmpCounter++;
-                                if (tmpCounter % 10 == 0) QThread::usleep(1);
-                                workingLocker.relock();
-                                loggerLocker.relock();
-                            }
-                        }
-                    }
-                    
-                    // 替换到原始树
-                    {
-                        QMutexLocker searchLocker(&m_searchFlagMutex);
-                        while (m_searchMutexCounter.loadRelaxed() != 0) {
-                            searchLocker.unlock();
-                            QThread::usleep(1);
-                            searchLocker.relock();
-                        }
-                        m_searchMutexCounter.storeRelaxed(-1);
-                    }
-                    
-                    if (fatherPtr->left_son_ptr == *m_rebuildPtr) {
-                        fatherPtr->left_son_ptr = newRootNode;
-                    } else if (fatherPtr->right_son_ptr == *m_rebuildPtr) {
-                        fatherPtr->right_son_ptr = newRootNode;
-                    } else {
-                        qCritical() << u8"错误: 父指针与当前节点不兼容";
-                    }
-                    
-                    if (newRootNode != nullptr) newRootNode->father_ptr = fatherPtr;
-                    (*m_rebuildPtr) = newRootNode;
-                    
-                    if (fatherPtr == m_staticRootNode) m_rootNode = m_staticRootNode->left_son_ptr;
-                    
-                    KD_TREE_NODE* updateRoot = *m_rebuildPtr;
-                    while (updateRoot != nullptr && updateRoot != m_rootNode) {
-                        updateRoot = updateRoot->father_ptr;
-                        if (updateRoot->working_flag) break;
-                        if (updateRoot == updateRoot->father_ptr->left_son_ptr && updateRoot->father_ptr->need_push_down_to_left) break;
-                        if (updateRoot == updateRoot->father_ptr->right_son_ptr && updateRoot->father_ptr->need_push_down_to_right) break;
-                        update(updateRoot);
-                    }
-                    
-                    {
-                        QMutexLocker searchLocker(&m_searchFlagMutex);
-                        m_searchMutexCounter.storeRelaxed(0);
-                    }
-                    
-                    m_rebuildPtr = nullptr;
-                    workingLocker.unlock();
-                    m_rebuildFlag.storeRelaxed(0);
-                    
-                    // 删除废弃的树节点
-                    deleteTreeNodes(&oldRootNode);
-                }
-            }
-            
-            QThread::usleep(100);
-        }
-        
-        qDebug() << u8"重建线程正常终止";
-    }
-
-public:
-    // 公有成员变量
-    PointVector m_pclStorage;                  ///< 点云存储向量
-    KD_TREE_NODE* m_rootNode = nullptr;        ///< 根节点指针
-    int m_maxQueueSize = 0;                    ///< 最大队列大小记录
+    static constexpr int SEARCH_DEADLINE_CHECK_INTERVAL = 32;
     
     /**
-     * @brief 构造函数 - 初始化ikd-Tree
-     * @param deleteParam 删除判据参数
-     * @param balanceParam 平衡判据参数  
-     * @param boxLength 下采样包围盒边长
+     * @brief 单个查询的节点预算 - 进入的节点数达到limit时才检查上限和截止时刻，不限时limit为int最大值
      */
-    explicit KD_TREE(double deleteParam = 0.5, double balanceParam = 0.6, double boxLength = 0.2)
-        : m_terminationFlag(0), m_rebuildFlag(0), m_searchMutexCounter(0)
+    struct SEARCH_BUDGET
     {
+        int limit;                  ///< 下一次检查前允许达到的节点数
+        int maxVisited;             ///< 进入节点数上限
+        QDeadlineTimer deadline;    ///< 截止时刻
+        bool truncated = false;     ///< 是否在仍有可能改进结果的子树时停止
+        
+        explicit SEARCH_BUDGET(int maxVisitedNodes = 0,
+                               const QDeadlineTimer& deadlineTimer = QDeadlineTimer(QDeadlineTimer::Forever))
+            : maxVisited(maxVisitedNodes > 0 ? maxVisitedNodes : std::numeric_limits<int>::max()), deadline(deadlineTimer)
+        {
+            // 有截止时刻时进入第一个节点前即检查，已过期的时限不进入任何节点
+            limit = deadline.isForever() ? maxVisited : 0;
+        }
+        
         /**
-         * @brief 构造函数实现 - 初始化ikd-Tree所有参数
+         * @brief 是否还能进入下一个节点
          */
-        m_deleteCriterionParam = deleteParam;
-        m_balanceCriterionParam = balanceParam;
-        m_downsampleSize = boxLength;
-        m_rebuildLogger.clear();
-        startThread();
-        
-        qDebug() << u8"ikd-Tree Qt版本初始化完成" 
-                 << u8"删除参数:" << deleteParam 
-                 << u8"平衡参数:" << balanceParam;
-    }
+        bool allows(int visited)
+        {
+            if (visited < limit) return true;
+            if (visited >= maxVisited || deadline.hasExpired()) return false;
+            limit = qMin(maxVisited, visited + SEARCH_DEADLINE_CHECK_INTERVAL);
+            return true;
+        }
+    };
     
     /**
-     * @brief 析构函数实现 - 清理所有资源
+     * @brief K近邻遍历栈帧 - 待访问子树及其出栈时的剪枝下界
      */
-    ~KD_TREE()
+    struct SEARCH_FRAME
     {
-        stopThread();
-        m_deleteStorageDisabled = true;
-        deleteTreeNodes(&m_rootNode);
-        m_pclStorage.clear();
-        m_rebuildLogger.clear();
-        
-        qDebug() << u8"ikd-Tree Qt版本资源清理完成";
-    }
+        NodeIndex index;        ///< 子树根节点索引
+        quint8 inherited;       ///< 子树根继承的删除状态位
+        Scalar bound;           ///< 子树中点到查询点距离平方的下界，出栈时与当时的堆顶比较；-inf表示必定访问
+    };
     
     /**
-     * @brief 设置删除判据参数
+     * @brief 分割面剪枝遍历栈帧 - 额外携带查询点到子树单元的各轴偏移
      */
-    void setDeleteCriterionParam(double deleteParam)
+    struct SPLIT_FRAME
     {
-        /**
-         * @brief 设置删除判据参数实现
-         */
-        QMutexLocker locker(&m_workingFlagMutex);
-        m_deleteCriterionParam = deleteParam;
-    }
+        NodeIndex index;        ///< 子树根节点索引
+        quint8 inherited;       ///< 同SEARCH_FRAME::inherited
+        Scalar bound;           ///< 同SEARCH_FRAME::bound
+        Scalar offset[3];       ///< 查询点到子树单元的各轴偏移（单元内为0）
+    };
     
     /**
-     * @brief 设置平衡判据参数
+     * @brief 范围查询遍历栈帧 - 待访问子树及其继承的删除状态位
      */
-    void setBalanceCriterionParam(double balanceParam)
+    struct QUERY_FRAME
     {
-        /**
-         * @brief 设置平衡判据参数实现
-         */
-        QMutexLocker locker(&m_workingFlagMutex);
-        m_balanceCriterionParam = balanceParam;
-    }
+        NodeIndex index;        ///< 子树根节点索引
+        quint8 inherited;       ///< 同SEARCH_FRAME::inherited
+    };
     
     /**
-     * @brief 设置下采样参数
+     * @brief 后序遍历栈帧 - 先序阶段压入子节点，后序阶段完成收尾
      */
-    void setDownsampleParam(double downsampleParam)
+    struct VISIT_FRAME
     {
-        /**
-         * @brief 设置下采样参数实现
-         */
-        QMutexLocker locker(&m_workingFlagMutex);
-        m_downsampleSize = downsampleParam;
-    }
+        NodeIndex index;        ///< 子树根节点索引，后序阶段不必再经父节点读取
+        bool post;              ///< 是否为后序阶段
+        NodeIndex* slot;        ///< 指向子树根的链接槽，释放子树时置空
+    };
     
     /**
-     * @brief 重新初始化K-D树参数
+     * @brief 构建栈帧 - 待构建的点区间及其链接槽
      */
-    void initializeKdTree(double deleteParam = 0.5, double balanceParam = 0.7, double boxLength = 0.2)
+    struct BUILD_FRAME
     {
-        /**
-         * @brief 重新初始化K-D树参数实现
-         */
-        setDeleteCriterionParam(deleteParam);
-        setBalanceCriterionParam(balanceParam);
-        setDownsampleParam(boxLength);
-    }
+        NodeIndex* slot;        ///< 构建结果写入的链接槽
+        int l, r;               ///< 点区间[l, r]
+        bool post;              ///< 是否为后序阶段（子树完成后更新节点）
+    };
     
     /**
-     * @brief 获取树大小 - 线程安全版本
+     * @brief 查询继承的删除状态位 - 祖先尚未下推的懒删除标记随栈帧向下传递，查询路径不调用pushDown、不写节点
      */
-    int size() const
+    enum : quint8
     {
-        /**
-         * @brief 获取树大小实现 - 线程安全版本
-         */
-        if (m_rebuildPtr == nullptr || *m_rebuildPtr != m_rootNode) {
-            if (m_rootNode != nullptr) {
-                return m_rootNode->TreeSize;
-            } else {
-                return 0;
-            }
-        } else {
-            QMutexLocker locker(&m_workingFlagMutex);
-            if (locker.mutex()->tryLock()) {
-                int s = m_rootNode->TreeSize;
-                locker.unlock();
-                return s;
-            } else {
-                return m_treesizeTemp;
-            }
-        }
-    }
+        INHERIT_NONE = 0,                   ///< 路径上没有未下推的标记，节点自身的删除标志有效
+        INHERIT_PENDING = 1,                ///< 父节点有未下推的标记，节点的删除标志按下推后的值解读
+        INHERIT_TREE_DELETED = 2,           ///< 父节点下推后的子树删除标志
+        INHERIT_DOWNSAMPLE_DELETED = 4      ///< 父节点下推后的子树下采样删除标志
+    };
     
     /**
-     * @brief 获取有效节点数
+     * @brief 节点在查询中的有效删除状态 - 与沿查询路径依次下推后节点上的标志相同
      */
-    int validnum() const
+    struct DELETE_VIEW
     {
-        /**
-         * @brief 获取有效节点数实现
-         */
-        if (m_rebuildPtr == nullptr || *m_rebuildPtr != m_rootNode) {
-            if (m_rootNode != nullptr)
-                return (m_rootNode->TreeSize - m_rootNode->invalid_point_num);
-            else 
-                return 0;
-        } else {
-            QMutexLocker locker(&m_workingFlagMutex);
-            if (locker.mutex()->tryLock()) {
-                int s = m_rootNode->TreeSize - m_rootNode->invalid_point_num;
-                locker.unlock();
-                return s;
-            } else {
-                return -1;
-            }
-        }
-    }
+        bool treeDeleted;       ///< 子树删除标志
+        bool pointDeleted;      ///< 点删除标志
+        quint8 leftInherited;   ///< 左子树根继承的删除状态位
+        quint8 rightInherited;  ///< 右子树根继承的删除状态位
+    };
     
     /**
-     * @brief 获取树范围 - 返回整个树的包围盒
+     * @brief 批量K近邻每组交错推进的查询数 - 组内查询轮流进入一个节点，相互填充访存等待
      */
-    BoxPointType treeRange() const
-    {
-        /**
-         * @brief 获取树范围实现 - 返回整个树的包围盒
-         */
-        BoxPointType range;
-        if (m_rebuildPtr == nullptr || *m_rebuildPtr != m_rootNode) {
-            if (m_rootNode != nullptr) {
-                range.vertex_min[0] = m_rootNode->node_range_x[0];
-                range.vertex_min[1] = m_rootNode->node_range_y[0];
-                range.vertex_min[2] = m_rootNode->node_range_z[0];
-                range.vertex_max[0] = m_rootNode->node_range_x[1];
-                range.vertex_max[1] = m_rootNode->node_range_y[1];
-                range.vertex_max[2] = m_rootNode->node_range_z[1];
-            } else {
-                range = BoxPointType();
-            }
-        } else {
-            QMutexLocker locker(&m_workingFlagMutex);
-            if (locker.mutex()->tryLock()) {
-                range.vertex_min[0] = m_rootNode->node_range_x[0];
-                range.vertex_min[1] = m_rootNode->node_range_y[0];
-                range.vertex_min[2] = m_rootNode->node_range_z[0];
-                range.vertex_max[0] = m_rootNode->node_range_x[1];
-                range.vertex_max[1] = m_rootNode->node_range_y[1];
-                range.vertex_max[2] = m_rootNode->node_range_z[1];
-                locker.unlock();
-            } else {
-                range = BoxPointType();
-            }
-        }
-        return range;
-    }
+    static constexpr int BATCH_SEARCH_GROUP = 8;
     
     /**
-     * @brief 获取平衡因子和删除因子
+     * @brief 批量K近邻单个查询的状态机 - 结果堆、延后访问的子树和下一个要进入的节点
      */
-    void rootAlpha(double& alphaBal, double& alphaDel) const
+    template<typename Frame>
+    struct BATCH_QUERY
     {
-        /**
-         * @brief 获取根节点平衡因子实现
-         */
-        if (m_rebuildPtr == nullptr || *m_rebuildPtr != m_rootNode) {
-            alphaBal = m_rootNode->alpha_bal;
-            alphaDel = m_rootNode->alpha_del;
-            return;
-        } else {
-            QMutexLocker locker(&m_workingFlagMutex);
-            if (locker.mutex()->tryLock()) {
-                alphaBal = m_rootNode->alpha_bal;
-                alphaDel = m_rootNode->alpha_del;
-                locker.unlock();
-                return;
-            } else {
-                alphaBal = m_alphaBalTemp;
-                alphaDel = m_alphaDelTemp;      
-                return;
-            }
-        }    
-    }
+        int query = -1;                 ///< 查询序号，-1表示槽位空闲
+        NodeIndex index = NULL_NODE;    ///< 下一个要进入的节点，NULL_NODE表示应先出栈
+        quint8 inherited = INHERIT_NONE; ///< index继承的删除状态位
+        bool expand = false;            ///< 包围盒剪枝：index已进入，下一步展开其子节点
+        int visited = 0;                ///< 已进入的节点数
+        Scalar cell[3] = {0, 0, 0};     ///< 分割面剪枝：当前单元的各轴偏移
+        MANUAL_HEAP q;                  ///< K近邻结果堆
+        TraversalStack<Frame> stack;    ///< 延后访问的子树
+    };
+
+    /**
+     * @brief 区域写分区深度上限 - 分区数不超过2^MAX_WRITER_PARTITION_DEPTH
+     */
+    static constexpr int MAX_WRITER_PARTITION_DEPTH = 6;
+    static constexpr int MAX_WRITER_PARTITIONS = 1 << MAX_WRITER_PARTITION_DEPTH;
     
     /**
-     * @brief 构建K-D树
+     * @brief 区域写会话中的上层节点 - 分区深度以上的普通节点，会话期间结构不变，统计信息在会话结束时更新
      */
-    void build(const PointVector& pointCloud)
+    struct UPPER_NODE
     {
-        /**
-         * @brief 构建K-D树实现 - 从点云数据构建完整的树
-         */
-        if (m_rootNode != nullptr) {
-            deleteTreeNodes(&m_rootNode);
-        }
-        if (pointCloud.size() == 0) return;
-        
-        m_staticRootNode = new KD_TREE_NODE;
-        initTreeNode(m_staticRootNode);
-        
-        // 复制点云数据到临时存储
-        PointVector tempStorage = pointCloud;
-        buildTree(&m_staticRootNode->left_son_ptr, 0, tempStorage.size()-1, tempStorage);
-        update(m_staticRootNode);
-        m_staticRootNode->TreeSize = 0;
-        m_rootNode = m_staticRootNode->left_son_ptr;
-        
-        qDebug() << u8"K-D树构建完成，节点数:" << pointCloud.size();
-    }
+        NodeIndex index;        ///< 节点索引
+        qint32 son[2];          ///< 左右子节点：非负为上层节点序号，负数为分区序号按位取反
+    };
     
     /**
-     * @brief 包围盒搜索
+     * @brief 区域写分区 - 分区子树根所在的链接槽，各分区由独立的互斥锁保护
      */
-    void boxSearch(const BoxPointType& boxOfPoint, PointVector& storage)
+    struct WRITER_PARTITION
     {
-        /**
-         * @brief 包围盒搜索实现
-         */
-        storage.clear();
-        searchByRange(m_rootNode, boxOfPoint, storage);
-    }
+        NodeIndex* slot;        ///< 分区子树根所在的链接槽，位于上层节点或m_rootNode中
+        int fatherAxis;         ///< 槽位为空时新节点的父分割轴
+    };
     
     /**
-     * @brief 半径搜索
+     * @brief 区域写操作涉及的分区 - 按序号升序，多分区操作按此顺序加锁
      */
-    void radiusSearch(const PointType& point, double radius, PointVector& storage)
+    struct REGION_TOUCH
     {
-        /**
-         * @brief 半径搜索实现
-         */
-        storage.clear();
-        searchByRadius(m_rootNode, point, radius, storage);
-    }
-    
+        QVarLengthArray<int, 8> partitions; ///< 涉及的分区序号
+        bool upper = false;     ///< 是否涉及上层节点自身的点
+    };
 
-    
     /**
-     * @brief 添加点集合
+     * @brief 节点内存池 - 按块批量分配缓存行对齐的节点，以32位索引寻址
+     * 
+     * 每块连续存放NODE_POOL_CHUNK_SIZE个节点，块表扩容时旧表延迟到clear()释放，
+     * 因此其他线程可以无锁地将索引解析为节点指针。释放的节点通过left_son_idx串成空闲链表复用。
+     * 块带引用计数，快照通过shareFrom()共享块而不复制节点；写入前经writableNode()检查，
+     * 仍被快照共享的块先复制一份再写，快照看到的块内容从此不再变化。
+     * 后台重建任务不持树锁写入新节点，beginOwnedAllocation()之后该线程只从专属块分配；
+     * 快照不共享专属块，对应块表条目为空，快照从其根节点出发也不会到达这些节点
      */
-    int addPoints(PointVector& pointToAdd, bool downsampleOn)
+    class NODE_POOL
     {
+    public:
+        static constexpr int NODE_POOL_CHUNK_SHIFT = 12;
+        static constexpr int NODE_POOL_CHUNK_SIZE = 1 << NODE_POOL_CHUNK_SHIFT;
+
         /**
-         * @brief 批量添加点实现 - 支持下采样功能
+         * @brief 节点块 - 引用计数与节点数组，节点数组按节点对齐要求起始
          */
-        int newPointSize = pointToAdd.size();
-        int treeSize = size();
-        BoxPointType boxOfPoint;
-        PointType downsampleResult, midPoint;
-        bool downsampleSwitch = downsampleOn && DOWNSAMPLE_SWITCH;
-        double minDist, tmpDist;
-        int tmpCounter = 0;
+        struct NODE_CHUNK
+        {
+            QAtomicInt ref;                             ///< 持有此块的内存池数量
+            KD_TREE_NODE nodes[NODE_POOL_CHUNK_SIZE];   ///< 节点数组
+        };
+
+        NODE_POOL() = default;
+        ~NODE_POOL() { clear(); }
+        NODE_POOL(const NODE_POOL&) = delete;
+        NODE_POOL& operator=(const NODE_POOL&) = delete;
 
-        Q_UNUSED(newPointSize);
-        Q_UNUSED(treeSize);
-        
-        for (int i = 0; i < pointToAdd.size(); i++) {
-            if (downsampleSwitch) {
-                boxOfPoint.vertex_min[0] = qFloor(pointToAdd[i].x / m_downsampleSize) * m_downsampleSize;
-                boxOfPoint.vertex_max[0] = boxOfPoint.vertex_min[0] + m_downsampleSize;
-                boxOfPoint.vertex_min[1] = qFloor(pointToAdd[i].y / m_downsampleSize) * m_downsampleSize;
-                boxOfPoint.vertex_max[1] = boxOfPoint.vertex_min[1] + m_downsampleSize;
-                boxOfPoint.vertex_min[2] = qFloor(pointToAdd[i].z / m_downsampleSize) * m_downsampleSize;
-                boxOfPoint.vertex_max[2] = boxOfPoint.vertex_min[2] + m_downsampleSize;
-                
-                midPoint.x = boxOfPoint.vertex_min[0] + (boxOfPoint.vertex_max[0] - boxOfPoint.vertex_min[0]) / 2.0;
-                midPoint.y = boxOfPoint.vertex_min[1] + (boxOfPoint.vertex_max[1] - boxOfPoint.vertex_min[1]) / 2.0;
-                midPoint.z = boxOfPoint.vertex_min[2] + (boxOfPoint.vertex_max[2] - boxOfPoint.vertex_min[2]) / 2.0;
-                
-                m_downsampleStorage.clear();
-                searchByRange(m_rootNode, boxOfPoint, m_downsampleStorage);
-                minDist = calcDist(pointToAdd[i], midPoint);
-                downsampleResult = pointToAdd[i];
-                
-                for (int index = 0; index < m_downsampleStorage.size(); index++) {
-                    tmpDist = calcDist(m_downsampleStorage[index], midPoint);
-                    if (tmpDist < minDist) {
-                        minDist = tmpDist;
-                        downsampleResult = m_downsampleStorage[index];
-                    }
-                }
-                
-                if (m_rebuildPtr == nullptr || *m_rebuildPtr != m_rootNode) {
-                    if (m_downsampleStorage.size() > 1 || samePoint(pointToAdd[i], downsampleResult)) {
-                        if (m_downsampleStorage.size() > 0) {
-                            deleteByRange(&m_rootNode, boxOfPoint, true, true);
-                        }
-                        addByPoint(&m_rootNode, downsampleResult, true, m_rootNode->division_axis);
-                        tmpCounter++;
-                    }
-                } else {
-                    if (m_downsampleStorage.size() > 1 || samePoint(pointToAdd[i], downsampleResult)) {
-                        Operation_Logger_Type operationDelete, operation;
-                        operationDelete.boxpoint = boxOfPoint;
-                        operationDelete.op = DOWNSAMPLE_DELETE;
-                        operation.point = downsampleResult;
-                        operation.op = ADD_POINT;
-                        
-                        QMutexLocker workingLocker(&m_workingFlagMutex);
-                        if (m_downsampleStorage.size() > 0) {
-                            deleteByRange(&m_rootNode, boxOfPoint, false, true);
-                        }
-                        addByPoint(&m_rootNode, downsampleResult, false, m_rootNode->division_axis);
-                        tmpCounter++;
-                        
-                        if (m_rebuildFlag.loadRelaxed()) {
-                            QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                            if (m_downsampleStorage.size() > 0) {
-                                m_rebuildLogger.push(operationDelete);
-                            }
-                            m_rebuildLogger.push(operation);
-                        }
-                    }
-                }
-            } else {
-                if (m_rebuildPtr == nullptr || *m_rebuildPtr != m_rootNode) {
-                    addByPoint(&m_rootNode, pointToAdd[i], true, m_rootNode->division_axis);
-                } else {
-                    Operation_Logger_Type operation;
-                    operation.point = pointToAdd[i];
-                    operation.op = ADD_POINT;
-                    
-                    QMutexLocker workingLocker(&m_workingFlagMutex);
-                    addByPoint(&m_rootNode, pointToAdd[i], false, m_rootNode->division_axis);
-                    
-                    if (m_rebuildFlag.loadRelaxed()) {
-                        QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                        m_rebuildLogger.push(operation);
-                    }
-                }
-            }
-        }
-        return tmpCounter;
-    }
-    
-    /**
-     * @brief 删除点集合
-     */
-    void deletePoints(PointVector& pointToDel)
-    {
         /**
-         * @brief 批量删除点实现
+         * @brief 将索引解析为节点指针，仅用于读取
          */
-        for (int i = 0; i < pointToDel.size(); i++) {
-            if (m_rebuildPtr == nullptr || *m_rebuildPtr != m_rootNode) {
-                deleteByPoint(&m_rootNode, pointToDel[i], true);
-            } else {
-                Operation_Logger_Type operation;
-                operation.point = pointToDel[i];
-                operation.op = DELETE_POINT;
-                
-                QMutexLocker workingLocker(&m_workingFlagMutex);
-                deleteByPoint(&m_rootNode, pointToDel[i], false);
-                
-                if (m_rebuildFlag.loadRelaxed()) {
-                    QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                    m_rebuildLogger.push(operation);
-                }
-            }
+        KD_TREE_NODE* node(NodeIndex index) const
+        {
+            return m_chunkTable.loadAcquire()[index >> NODE_POOL_CHUNK_SHIFT].loadAcquire()->nodes
+                   + (index & (NODE_POOL_CHUNK_SIZE - 1));
         }
-    }
-    
-    /**
-     * @brief 添加包围盒集合
-     */
-    void addPointBoxes(QVector<BoxPointType>& boxPoints)
-    {
+
         /**
-         * @brief 批量添加包围盒实现 - 恢复指定区域内的点
+         * @brief 将索引解析为可写的节点指针，所在块仍被快照共享时先复制
          */
-        for (int i = 0; i < boxPoints.size(); i++) {
-            if (m_rebuildPtr == nullptr || *m_rebuildPtr != m_rootNode) {
-                addByRange(&m_rootNode, boxPoints[i], true);
-            } else {
-                Operation_Logger_Type operation;
-                operation.boxpoint = boxPoints[i];
-                operation.op = ADD_BOX;
-                
-                QMutexLocker workingLocker(&m_workingFlagMutex);
-                addByRange(&m_rootNode, boxPoints[i], false);
-                
-                if (m_rebuildFlag.loadRelaxed()) {
-                    QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                    m_rebuildLogger.push(operation);
-                }
+        KD_TREE_NODE* writableNode(NodeIndex index)
+        {
+            const int chunkIndex = index >> NODE_POOL_CHUNK_SHIFT;
+            NODE_CHUNK* chunk = m_chunkTable.loadAcquire()[chunkIndex].loadAcquire();
+            // 引用计数为1也可能是另一线程刚复制并替换了此块，复查块表中仍是此块
+            if (chunk->ref.loadAcquire() > 1 || m_chunkTable.loadAcquire()[chunkIndex].loadAcquire() != chunk) {
+                chunk = detachChunk(chunkIndex);
             }
+            return chunk->nodes + (index & (NODE_POOL_CHUNK_SIZE - 1));
         }
-    }
-    
-    /**
-     * @brief 删除包围盒集合
-     */
-    int deletePointBoxes(QVector<BoxPointType>& boxPoints)
-    {
-        /**
-         * @brief 批量删除包围盒实现
-         */
-        int tmpCounter = 0;
-        for (int i = 0; i < boxPoints.size(); i++) {
-            if (m_rebuildPtr == nullptr || *m_rebuildPtr != m_rootNode) {
-                tmpCounter += deleteByRange(&m_rootNode, boxPoints[i], true, false);
+
+        NodeIndex allocate()
+        {
+            QMutexLocker locker(&m_mutex);
+            NodeIndex index = m_freeList;
+            if (m_ownerThread != nullptr && m_ownerThread == QThread::currentThreadId()) {
+                // 专属块用完时追加新块，不取空闲链表中可能位于共享块的节点
+                if ((m_ownedNext & (NODE_POOL_CHUNK_SIZE - 1)) == 0) {
+                    m_ownedNext = quint64(m_chunkCount) << NODE_POOL_CHUNK_SHIFT;
+                    m_ownedChunks.append(m_chunkCount);
+                    appendChunk();
+                    if (m_ownedNext == NULL_NODE) m_ownedNext++;
+                }
+                index = NodeIndex(m_ownedNext++);
+            } else if (index != NULL_NODE) {
+                m_freeList = node(index)->left_son_idx;
             } else {
-                Operation_Logger_Type operation;
-                operation.boxpoint = boxPoints[i];
-                operation.op = DELETE_BOX;
-                
-                QMutexLocker workingLocker(&m_workingFlagMutex);
-                tmpCounter += deleteByRange(&m_rootNode, boxPoints[i], false, false);
-                
-                if (m_rebuildFlag.loadRelaxed()) {
-                    QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                    m_rebuildLogger.push(operation);
+                // 中间可能夹有专属块，当前块用完时总是追加新块
+                if (m_chunkCount == 0 || (m_nextIndex & (NODE_POOL_CHUNK_SIZE - 1)) == 0) {
+                    if (m_chunkCount > 0) m_nextIndex = quint64(m_chunkCount) << NODE_POOL_CHUNK_SHIFT;
+                    appendChunk();
                 }
+                index = NodeIndex(m_nextIndex++);
             }
+            *writableNode(index) = KD_TREE_NODE();
+            m_liveCount++;
+            return index;
         }
-        return tmpCounter;
-    }
-    
-    /**
-     * @brief 平铺树节点
-     */
-    void flatten(KD_TREE_NODE* root, PointVector& storage, delete_point_storage_set storageType)
-    {
+        
         /**
-         * @brief 展平树结构实现 - 将子树所有点提取到向量中
+         * @brief 调用线程此后只从专属块分配，直到endOwnedAllocation()
          */
-        if (root == nullptr) return;
-        
-        pushDown(root);
-        if (!root->point_deleted) {
-            storage.append(root->point);
+        void beginOwnedAllocation()
+        {
+            QMutexLocker locker(&m_mutex);
+            m_ownerThread = QThread::currentThreadId();
+            m_ownedNext = 0;
         }
         
-        flatten(root->left_son_ptr, storage, storageType);
-        flatten(root->right_son_ptr, storage, storageType);
-        
-        switch (storageType) {
-        case NOT_RECORD:
-            break;
-        case DELETE_POINTS_REC:
-            if (root->point_deleted && !root->point_downsample_deleted) {
-                m_pointsDeleted.append(root->point);
-            }
-            break;
-        case MULTI_THREAD_REC:
-            if (root->point_deleted && !root->point_downsample_deleted) {
-                m_multithreadPointsDeleted.append(root->point);
-            }
-            break;
-        default:
-            break;
-        }
-    }
-    
-    /**
-     * @brief 获取已删除的点
-     */
-    void acquireRemovedPoints(PointVector& removedPoints)
-    {
         /**
-         * @brief 获取已删除点实现
+         * @brief 专属块转为普通块，未用的槽位放入空闲链表 - 调用者须保证期间没有快照创建
          */
-        QMutexLocker pointsLocker(&m_pointsDeletedRebuildMutex);
-        for (int i = 0; i < m_pointsDeleted.size(); i++) {
-            removedPoints.append(m_pointsDeleted[i]);
+        void endOwnedAllocation()
+        {
+            QMutexLocker locker(&m_mutex);
+            while ((m_ownedNext & (NODE_POOL_CHUNK_SIZE - 1)) != 0) {
+                const NodeIndex index = NodeIndex(m_ownedNext++);
+                writableNode(index)->left_son_idx = m_freeList;
+                m_freeList = index;
+            }
+            m_ownerThread = nullptr;
+            m_ownedNext = 0;
+            m_ownedChunks.clear();
         }
-        for (int i = 0; i < m_multithreadPointsDeleted.size(); i++) {
-            removedPoints.append(m_multithreadPointsDeleted[i]);
+
+        void release(NodeIndex index)
+        {
+            QMutexLocker locker(&m_mutex);
+            writableNode(index)->left_son_idx = m_freeList;
+            m_freeList = index;
+            m_liveCount--;
         }
-        m_pointsDeleted.clear();
-        m_multithreadPointsDeleted.clear();
-    }
 
-    void startThread() {
         /**
-         * @brief 启动重建线程实现 - 使用Qt线程机制
+         * @brief 共享另一个内存池除专属块外的全部块 - 调用者须保证期间只有专属块的所有者写入source
          */
-        m_terminationFlag.storeRelaxed(0);
-        
-        // 创建重建线程
-        m_rebuildThread.reset(QThread::create([this]() {
-            this->multiThreadRebuild();
-        }));
-        
-        m_rebuildThread->start();
-        qDebug() << u8"Qt多线程重建已启动";
-    }
+        void shareFrom(const NODE_POOL& source)
+        {
+            QMutexLocker locker(&m_mutex);
+            QMutexLocker sourceLocker(&source.m_mutex);
+            const QAtomicPointer<NODE_CHUNK>* sourceTable = source.m_chunkTable.loadAcquire();
+            QAtomicPointer<NODE_CHUNK>* table = new QAtomicPointer<NODE_CHUNK>[qMax(1, source.m_chunkCount)];
+            for (int i = 0; i < source.m_chunkCount; i++) {
+                NODE_CHUNK* chunk = sourceTable[i].loadAcquire();
+                if (chunk == nullptr || source.m_ownedChunks.contains(i)) {
+                    table[i].storeRelaxed(nullptr);
+                    continue;
+                }
+                chunk->ref.ref();
+                table[i].storeRelaxed(chunk);
+            }
+            m_chunkTable.storeRelease(table);
+            m_chunkCount = source.m_chunkCount;
+            m_tableCapacity = qMax(1, source.m_chunkCount);
+            m_nextIndex = source.m_nextIndex;
+            m_liveCount = source.m_liveCount;
+        }
+
+        void clear()
+        {
+            QMutexLocker locker(&m_mutex);
+            QAtomicPointer<NODE_CHUNK>* table = m_chunkTable.loadRelaxed();
+            for (int i = 0; i < m_chunkCount; i++) {
+                NODE_CHUNK* chunk = table[i].loadAcquire();
+                if (chunk != nullptr && !chunk->ref.deref()) delete chunk;
+            }
+            delete[] table;
+            for (QAtomicPointer<NODE_CHUNK>* retired : m_retiredTables) delete[] retired;
+            m_retiredTables.clear();
+            m_chunkTable.storeRelease(nullptr);
+            m_chunkCount = 0;
+            m_tableCapacity = 0;
+            m_nextIndex = 1;
+            m_freeList = NULL_NODE;
+            m_liveCount = 0;
+        }
 
-    void stopThread() {
+        int liveCount() const { return m_liveCount; }
+        qint64 reservedBytes() const { return qint64(m_chunkCount) * NODE_POOL_CHUNK_SIZE * sizeof(KD_TREE_NODE); }
+        
         /**
-         * @brief 停止重建线程实现
+         * @brief 仍与其他内存池共享的块占用的字节数
          */
+        qint64 sharedBytes() const
         {
-            QMutexLocker locker(&m_terminationFlagMutex);
-            m_terminationFlag.storeRelaxed(1);
+            QMutexLocker locker(&m_mutex);
+            const QAtomicPointer<NODE_CHUNK>* table = m_chunkTable.loadAcquire();
+            int shared = 0;
+            for (int i = 0; i < m_chunkCount; i++) {
+                const NODE_CHUNK* chunk = table[i].loadAcquire();
+                if (chunk != nullptr && chunk->ref.loadAcquire() > 1) shared++;
+            }
+            return qint64(shared) * NODE_POOL_CHUNK_SIZE * sizeof(KD_TREE_NODE);
         }
-        
-        if (m_rebuildThread && m_rebuildThread->isRunning()) {
-            m_rebuildThread->quit();
-            m_rebuildThread->wait();
+
+    private:
+        void appendChunk()
+        {
+            if (m_chunkCount == m_tableCapacity) {
+                // 与detachChunk()互斥，避免复制旧表期间其条目被替换
+                QMutexLocker detachLocker(&m_detachMutex);
+                int newCapacity = qMax(16, m_tableCapacity * 2);
+                QAtomicPointer<NODE_CHUNK>* oldTable = m_chunkTable.loadRelaxed();
+                QAtomicPointer<NODE_CHUNK>* newTable = new QAtomicPointer<NODE_CHUNK>[newCapacity];
+                for (int i = 0; i < m_chunkCount; i++) newTable[i].storeRelaxed(oldTable[i].loadRelaxed());
+                // 旧表可能仍被其他线程读取，延迟到clear()释放
+                if (oldTable != nullptr) m_retiredTables.append(oldTable);
+                m_chunkTable.storeRelease(newTable);
+                m_tableCapacity = newCapacity;
+            }
+            NODE_CHUNK* chunk = new NODE_CHUNK;
+            chunk->ref.storeRelaxed(1);
+            m_chunkTable.loadRelaxed()[m_chunkCount].storeRelease(chunk);
+            m_chunkCount++;
         }
         
-        qDebug() << u8"Qt多线程重建已停止";
-    }
-
-    void initTreeNode(KD_TREE_NODE* root) {
         /**
-         * @brief 初始化树节点实现 - 设置节点默认值
+         * @brief 复制仍被共享的块并替换块表中的条目
+         * 
+         * 区域写线程或后台重建任务可能与写线程同时写同一块，复制在m_detachMutex下进行并复查；
+         * 被共享的块不会被任何写线程修改，复制期间其内容稳定
          */
-        if (!root) return;
-        
-        root->point = PointType(0.0, 0.0, 0.0);
-        root->node_range_x[0] = root->node_range_x[1] = 0.0;
-        root->node_range_y[0] = root->node_range_y[1] = 0.0;
-        root->node_range_z[0] = root->node_range_z[1] = 0.0;
-        root->division_axis = 0;
-        root->father_ptr = nullptr;
-        root->left_son_ptr = nullptr;
-        root->right_son_ptr = nullptr;
-        root->TreeSize = 0;
-        root->invalid_point_num = 0;
-        root->down_del_num = 0;
-        root->point_deleted = false;
-        root->tree_deleted = false;
-        root->need_push_down_to_left = false;
-        root->need_push_down_to_right = false;
-        root->point_downsample_deleted = false;
-        root->working_flag = false;
-        // Qt的QMutex已经在构造函数中自动初始化
-    }
+        NODE_CHUNK* detachChunk(int chunkIndex)
+        {
+            QMutexLocker locker(&m_detachMutex);
+            QAtomicPointer<NODE_CHUNK>& entry = m_chunkTable.loadAcquire()[chunkIndex];
+            NODE_CHUNK* shared = entry.loadAcquire();
+            if (shared->ref.loadAcquire() == 1) return shared;
+            NODE_CHUNK* copy = new NODE_CHUNK;
+            copy->ref.storeRelaxed(1);
+            std::copy(shared->nodes, shared->nodes + NODE_POOL_CHUNK_SIZE, copy->nodes);
+            entry.storeRelease(copy);
+            if (!shared->ref.deref()) delete shared;
+            return copy;
+        }
 
-    void buildTree(KD_TREE_NODE** root, int l, int r, PointVector& storage) {
+        QAtomicPointer<QAtomicPointer<NODE_CHUNK>> m_chunkTable;   ///< 块表：块序号 -> 块
+        QVector<QAtomicPointer<NODE_CHUNK>*> m_retiredTables;       ///< 扩容后废弃的旧块表
+        int m_chunkCount = 0;                       ///< 已分配的块数
+        int m_tableCapacity = 0;                    ///< 块表容量
+        quint64 m_nextIndex = 1;                    ///< 下一个未使用的槽位
+        NodeIndex m_freeList = NULL_NODE;           ///< 空闲节点链表
+        int m_liveCount = 0;                        ///< 存活节点数
+        Qt::HANDLE m_ownerThread = nullptr;         ///< 从专属块分配的线程，没有时为空
+        quint64 m_ownedNext = 0;                    ///< 专属块中下一个未使用的槽位
+        QVector<int> m_ownedChunks;                 ///< 专属块序号，快照不共享
+        mutable Mutex m_mutex;                      ///< 写线程与后台重建任务共享时的分配锁
+        Mutex m_detachMutex;                        ///< 并发写线程复制共享块及块表扩容时的互斥锁
+    };
+
+    using PayloadType = std::remove_cv_t<decltype(PointType::data)>; ///< 点附加数据类型
+    
+    /**
+     * @brief 叶块 - 将小子树的点按分量连续存放（先全部x，再全部y、z）
+     * 
+     * 两种编码：压缩叶块以包围盒最小顶点为原点存放16位网格偏移，开启压缩后入树坐标均对齐到
+     * 全树统一的量化网格，解码结果与对齐后的坐标逐位相同；精确叶桶直接存放坐标，按分量连续的布局
+     * 便于编译器向量化距离计算。叶块内的点整体有效或整体删除，局部删除前先解冻为普通节点
+     */
+    struct LEAF_BLOCK
+    {
+        qint64 origin[3] = {0, 0, 0};   ///< 包围盒最小顶点的网格坐标
+        double step = 0;                ///< 网格步长，即量化分辨率；0表示精确叶桶
+        int count = 0;                  ///< 点数量
+        int stride = 0;                 ///< 每个分量段的长度，不小于count，精确叶桶预留到桶容量
+        QVector<quint16> codes;         ///< 量化坐标 [x0..xn-1, y0..yn-1, z0..zn-1]，各段长stride
+        QVector<Scalar> coords;         ///< 精确坐标 [x0..xn-1, y0..yn-1, z0..zn-1]，各段长stride
+        QVector<PayloadType> payload;   ///< 点附加数据
+        
         /**
-         * @brief 递归构建K-D树实现 - 核心构建算法
+         * @brief 解码第i个点在指定轴上的坐标
          */
-        if (l > r) return;
-        
-        *root = new KD_TREE_NODE;
-        initTreeNode(*root);
-        int mid = (l + r) >> 1;
-        int divAxis = 0;
-        
-        // 找到最佳分割轴
-        double minValue[3] = {std::numeric_limits<double>::infinity(), 
-                             std::numeric_limits<double>::infinity(), 
-                             std::numeric_limits<double>::infinity()};
-        double maxValue[3] = {-std::numeric_limits<double>::infinity(), 
-                             -std::numeric_limits<double>::infinity(), 
-                             -std::numeric_limits<double>::infinity()};
-        double dimRange[3] = {0, 0, 0};
-        
-        for (int i = l; i <= r; i++) {
-            minValue[0] = qMin(minValue[0], storage[i].x);
-            minValue[1] = qMin(minValue[1], storage[i].y);
-            minValue[2] = qMin(minValue[2], storage[i].z);
-            maxValue[0] = qMax(maxValue[0], storage[i].x);
-            maxValue[1] = qMax(maxValue[1], storage[i].y);
-            maxValue[2] = qMax(maxValue[2], storage[i].z);
-        }
-        
-        // 选择最长维度作为分割轴
-        for (int i = 0; i < 3; i++) dimRange[i] = maxValue[i] - minValue[i];
-        for (int i = 1; i < 3; i++) if (dimRange[i] > dimRange[divAxis]) divAxis = i;
-        
-        (*root)->division_axis = divAxis;
-        
-        // 按分割轴排序并递归构建
-        switch (divAxis) {
-        case 0:
-            std::nth_element(storage.begin() + l, storage.begin() + mid, storage.begin() + r + 1, pointCmpX);
-            break;
-        case 1:
-            std::nth_element(storage.begin() + l, storage.begin() + mid, storage.begin() + r + 1, pointCmpY);
-            break;
-        case 2:
-            std::nth_element(storage.begin() + l, storage.begin() + mid, storage.begin() + r + 1, pointCmpZ);
-            break;
-        default:
-            std::nth_element(storage.begin() + l, storage.begin() + mid, storage.begin() + r + 1, pointCmpX);
-            break;
+        Scalar coord(int axis, int i) const
+        {
+            if (step == 0) return coords[axis * stride + i];
+            return Scalar(double(origin[axis] + codes[axis * stride + i]) * step);
         }
         
-        (*root)->point = storage[mid];
-        KD_TREE_NODE* leftSon = nullptr;
-        KD_TREE_NODE* rightSon = nullptr;
-        buildTree(&leftSon, l, mid-1, storage);
-        buildTree(&rightSon, mid+1, r, storage);
-        (*root)->left_son_ptr = leftSon;
-        (*root)->right_son_ptr = rightSon;
-        update(*root);
-    }
-
-    void searchByRange(KD_TREE_NODE* root, const BoxPointType& boxpoint, PointVector& storage) {
         /**
-         * @brief 按范围搜索实现
+         * @brief 解码第i个点
          */
-        if (root == nullptr) return;
-        
-        pushDown(root);
-        
-        if (boxpoint.vertex_max[0] <= root->node_range_x[0] || boxpoint.vertex_min[0] > root->node_range_x[1]) return;
-        if (boxpoint.vertex_max[1] <= root->node_range_y[0] || boxpoint.vertex_min[1] > root->node_range_y[1]) return;
-        if (boxpoint.vertex_max[2] <= root->node_range_z[0] || boxpoint.vertex_min[2] > root->node_range_z[1]) return;
-        
-        if (boxpoint.vertex_min[0] <= root->node_range_x[0] && boxpoint.vertex_max[0] > root->node_range_x[1] && 
-            boxpoint.vertex_min[1] <= root->node_range_y[0] && boxpoint.vertex_max[1] > root->node_range_y[1] && 
-            boxpoint.vertex_min[2] <= root->node_range_z[0] && boxpoint.vertex_max[2] > root->node_range_z[1]) {
-            flatten(root, storage, NOT_RECORD);
-            return;
-        }
-        
-        if (boxpoint.vertex_min[0] <= root->point.x && boxpoint.vertex_max[0] > root->point.x && 
-            boxpoint.vertex_min[1] <= root->point.y && boxpoint.vertex_max[1] > root->point.y && 
-            boxpoint.vertex_min[2] <= root->point.z && boxpoint.vertex_max[2] > root->point.z) {
-            if (!root->point_deleted) storage.append(root->point);
-        }
-        
-        if ((m_rebuildPtr == nullptr) || root->left_son_ptr != *m_rebuildPtr) {
-            searchByRange(root->left_son_ptr, boxpoint, storage);
-        } else {
-            QMutexLocker searchLocker(&m_searchFlagMutex);
-            searchByRange(root->left_son_ptr, boxpoint, storage);
+        PointType decode(int i) const
+        {
+            PointType point;
+            point.x = coord(0, i);
+            point.y = coord(1, i);
+            point.z = coord(2, i);
+            point.data = payload[i];
+            return point;
         }
         
-        if ((m_rebuildPtr == nullptr) || root->right_son_ptr != *m_rebuildPtr) {
-            searchByRange(root->right_son_ptr, boxpoint, storage);
-        } else {
-            QMutexLocker searchLocker(&m_searchFlagMutex);
-            searchByRange(root->right_son_ptr, boxpoint, storage);
-        }
-    }
-
-    void searchByRadius(KD_TREE_NODE* root, const PointType& point, double radius, PointVector& storage) {
         /**
-         * @brief 按半径搜索实现
+         * @brief 计算叶块内全部点到查询点的距离平方
+         * 
+         * 按分量连续的数组上做无分支循环，主循环按固定宽度分组，-O2下也能由编译器向量化。
+         * 两种编码的结果都与对解码后的点调用calcDist()逐位相同
+         * @param point 查询点
+         * @param dist 输出距离平方，长度不小于count
          */
-        if (root == nullptr) return;
-        
-        pushDown(root);
-        PointType rangeCenter;
-        rangeCenter.x = (root->node_range_x[0] + root->node_range_x[1]) * 0.5;
-        rangeCenter.y = (root->node_range_y[0] + root->node_range_y[1]) * 0.5;
-        rangeCenter.z = (root->node_range_z[0] + root->node_range_z[1]) * 0.5;
-        
-        double dist = qSqrt(calcDist(rangeCenter, point));
-        if (dist > radius + qSqrt(root->radius_sq)) return;
-        
-        if (dist <= radius - qSqrt(root->radius_sq)) {
-            flatten(root, storage, NOT_RECORD);
-            return;
+        void distances(const PointType& point, Scalar* dist) const
+        {
+            constexpr int LANES = 4;
+            int i = 0;
+            if (step == 0) {
+                const Scalar px = point.x, py = point.y, pz = point.z;
+                const Scalar* xs = coords.constData();
+                const Scalar* ys = xs + stride;
+                const Scalar* zs = ys + stride;
+                auto kernel = [&](int k) {
+                    Scalar dx = xs[k] - px, dy = ys[k] - py, dz = zs[k] - pz;
+                    return dx * dx + dy * dy + dz * dz;
+                };
+                for (; i + LANES <= count; i += LANES) {
+                    Scalar lane[LANES];
+                    for (int j = 0; j < LANES; j++) lane[j] = kernel(i + j);
+                    for (int j = 0; j < LANES; j++) dist[i + j] = lane[j];
+                }
+                for (; i < count; i++) dist[i] = kernel(i);
+            } else {
+                const quint16* xs = codes.constData();
+                const quint16* ys = xs + stride;
+                const quint16* zs = ys + stride;
+                // 先按coord()解码再以坐标标量精度求差，结果与calcDist(point, decode(k))逐位一致
+                const Scalar px = point.x, py = point.y, pz = point.z;
+                auto kernel = [&](int k) {
+                    Scalar dx = Scalar(double(origin[0] + xs[k]) * step) - px;
+                    Scalar dy = Scalar(double(origin[1] + ys[k]) * step) - py;
+                    Scalar dz = Scalar(double(origin[2] + zs[k]) * step) - pz;
+                    return dx * dx + dy * dy + dz * dz;
+                };
+                for (; i + LANES <= count; i += LANES) {
+                    Scalar lane[LANES];
+                    for (int j = 0; j < LANES; j++) lane[j] = kernel(i + j);
+                    for (int j = 0; j < LANES; j++) dist[i + j] = lane[j];
+                }
+                for (; i < count; i++) dist[i] = kernel(i);
+            }
         }
         
-        if (!root->point_deleted && calcDist(root->point, point) <= radius * radius) {
-            storage.append(root->point);
+        /**
+         * @brief 向精确叶桶追加一个点 - 分量段已满时容量翻倍，逐点填满叶桶的总开销为线性
+         */
+        void append(const PointType& point)
+        {
+            if (count == stride) {
+                const int grownStride = qMax(2 * stride, 4);
+                QVector<Scalar> grown(3 * grownStride);
+                for (int a = 0; a < 3; a++) {
+                    std::copy(coords.constData() + a * stride, coords.constData() + a * stride + count,
+                              grown.data() + a * grownStride);
+                }
+                coords.swap(grown);
+                stride = grownStride;
+            }
+            coords[count] = point.x;
+            coords[stride + count] = point.y;
+            coords[2 * stride + count] = point.z;
+            payload.append(point.data);
+            count++;
         }
-        
-        if ((m_rebuildPtr == nullptr) || root->left_son_ptr != *m_rebuildPtr) {
-            searchByRadius(root->left_son_ptr, point, radius, storage);
+    };
+
+private:
+    // 后台重建相关 - 重建任务在KD_TREE_REBUILD_EXECUTOR上执行
+    QAtomicInt m_rebuildFlag;                   ///< 重建标志（原子操作），置位后对重建目标的修改记录到重建日志
+    mutable Mutex m_rebuildPtrMutex;            ///< 重建目标互斥锁，重建任务执行期间持有
+    mutable Mutex m_workingFlagMutex;           ///< 工作标志互斥锁
+    mutable Mutex m_rebuildLoggerMutex;         ///< 重建日志互斥锁
+    mutable Mutex m_pointsDeletedRebuildMutex;  ///< 删除点重建互斥锁
+    mutable ReadWriteLock m_treeLock;           ///< 树结构读写锁，查询共享持有，修改独占持有
+    typename ThreadPolicy::template OperationQueue<Operation_Logger_Type> m_rebuildLogger; ///< 重建操作日志队列
+    QAtomicInteger<NodeIndex> m_rebuildTarget;  ///< 待后台重建的子树根索引，NULL_NODE表示没有
+    QMutex m_rebuildTaskMutex;                  ///< 重建任务状态互斥锁
+    QWaitCondition m_rebuildTaskIdle;           ///< 重建任务结束条件
+    bool m_rebuildTaskPending = false;          ///< 是否有已提交且尚未结束的重建任务
+    
+    // K-D树函数和增强变量 - Qt风格命名
+    double m_deleteCriterionParam = 0.5;        ///< 删除判据参数 (改为double)
+    double m_balanceCriterionParam = 0.7;       ///< 平衡判据参数 (改为double)
+    double m_downsampleSize = 0.2;              ///< 下采样尺寸 (改为double)
+    bool m_deleteStorageDisabled = false;       ///< 删除存储禁用标志
+    NODE_POOL m_nodePool;                       ///< 节点内存池
+    NodeIndex m_staticRootNode = NULL_NODE;     ///< 静态根节点索引
+    QVector<LEAF_BLOCK> m_leafBlocks;           ///< 叶块表，0号槽位保留
+    QVector<quint32> m_freeLeafBlocks;          ///< 空闲叶块槽位
+    int m_compressedLeafSize = 0;               ///< 压缩叶块最大点数，0表示关闭压缩
+    double m_compressedResolution = 0.001;      ///< 压缩叶块量化分辨率
+    int m_leafBucketSize = 0;                   ///< 精确叶桶最大点数，0表示关闭；压缩开启时不生效
+    mutable Mutex m_leafBlockMutex;             ///< 叶块表分配锁
+    bool m_pointIdTracking = false;             ///< 是否按data成员维护点编号到节点的映射
+    QVector<NodeIndex> m_pointIdNodes;          ///< 点编号 -> 所在节点索引，构建、重建和插入时更新
+    bool m_splitPlanePruning = false;           ///< K近邻搜索是否按分割面增量距离剪枝
+    QAtomicInt m_writerPartitionDepth = 0;      ///< 区域写分区深度，0表示修改之间串行，修改入口不加锁读取
+    QVector<UPPER_NODE> m_regionUpper;          ///< 当前区域写会话的上层节点，先序排列，0号为根
+    QVector<WRITER_PARTITION> m_regionPartitions; ///< 当前区域写会话的分区
+    Mutex m_regionMutexes[MAX_WRITER_PARTITIONS]; ///< 分区锁
+    Mutex m_regionUpperMutex;                   ///< 上层节点自身点的删除标志锁，在分区锁之后获取
+    PointVector m_pointsDeleted;                ///< 已删除点集合
+    PointVector m_multithreadPointsDeleted;     ///< 多线程删除点集合
+    bool m_snapshot = false;                    ///< 是否为只读快照，析构时不释放与原树共享的节点
+    mutable QAtomicInteger<qint64> m_limitedSearches = 0;   ///< 带时限的查询次数
+    mutable QAtomicInteger<qint64> m_truncatedSearches = 0; ///< 其中被截断的次数
+
+    // 私有方法实现（header-only模板设计，无需声明）
+    
+    /**
+     * @brief 将节点索引解析为只读节点指针，空索引返回nullptr
+     */
+    const KD_TREE_NODE* node(NodeIndex index) const
+    {
+        return index == NULL_NODE ? nullptr : m_nodePool.node(index);
+    }
+    
+    /**
+     * @brief 将节点索引解析为可写节点指针，所在块被快照共享时先复制
+     */
+    KD_TREE_NODE* node(NodeIndex index)
+    {
+        return index == NULL_NODE ? nullptr : m_nodePool.writableNode(index);
+    }
+    
+    /**
+     * @brief 预取节点 - 提前发起剪枝热数据行和点数据行的读取，不访问节点内容
+     */
+    void prefetchNode(NodeIndex index) const
+    {
+        if constexpr (IKD_TREE_PREFETCH_DISTANCE > 0) {
+            if (index == NULL_NODE) return;
+            const KD_TREE_NODE* target = m_nodePool.node(index);
+            IKD_TREE_PREFETCH(target);
+            IKD_TREE_PREFETCH(&target->point);
         } else {
-            QMutexLocker searchLocker(&m_searchFlagMutex);
-            searchByRadius(root->left_son_ptr, point, radius, storage);
+            Q_UNUSED(index);
         }
-        
-        if ((m_rebuildPtr == nullptr) || root->right_son_ptr != *m_rebuildPtr) {
-            searchByRadius(root->right_son_ptr, point, radius, storage);
+    }
+    
+    /**
+     * @brief 预取遍历栈中即将恢复的子树根 - 预取距离大于1时生效
+     */
+    template<typename Frame>
+    void prefetchPending(const TraversalStack<Frame>& stack) const
+    {
+        if constexpr (IKD_TREE_PREFETCH_DISTANCE > 1) {
+            const int pending = stack.size() - (IKD_TREE_PREFETCH_DISTANCE - 1);
+            if (pending >= 0) prefetchNode(frameIndex(stack[pending]));
         } else {
-            QMutexLocker searchLocker(&m_searchFlagMutex);
-            searchByRadius(root->right_son_ptr, point, radius, storage);
+            Q_UNUSED(stack);
         }
     }
-
-    void nearestSearch(const PointType& point, int kNearest, PointVector& nearestPoints, 
-                      QVector<double>& pointDistance, double maxDist = std::numeric_limits<double>::infinity()) {
-        /**
-         * @brief K近邻搜索实现 - 搜索K个最近邻点
-         */
-        MANUAL_HEAP q(2 * kNearest);
-        q.clear();
-        pointDistance.clear();
-        
-        if (m_rebuildPtr == nullptr || *m_rebuildPtr != m_rootNode) {
-            search(m_rootNode, kNearest, point, q, maxDist);
-        } else {
-            QMutexLocker searchLocker(&m_searchFlagMutex);
-            while (m_searchMutexCounter.loadRelaxed() == -1) {
-                searchLocker.unlock();
-                QThread::usleep(1);
-                searchLocker.relock();
-            }
-            m_searchMutexCounter.fetchAndAddRelaxed(1);
-            searchLocker.unlock();
-            
-            search(m_rootNode, kNearest, point, q, maxDist);
-            
-            searchLocker.relock();
-            m_searchMutexCounter.fetchAndSubRelaxed(1);
+    
+    static NodeIndex frameIndex(NodeIndex index) { return index; }
+    template<typename Frame>
+    static NodeIndex frameIndex(const Frame& frame) { return frame.index; }
+    
+    /**
+     * @brief 计算节点在查询中的有效删除状态 - 按pushDown对子节点的赋值逐层推导继承位，不写节点
+     */
+    DELETE_VIEW deleteView(const KD_TREE_NODE* root, quint8 inherited) const
+    {
+        DELETE_VIEW view;
+        bool treeDownsampleDeleted = root->tree_downsample_deleted;
+        view.treeDeleted = root->tree_deleted;
+        view.pointDeleted = root->point_deleted;
+        const bool pending = inherited & INHERIT_PENDING;
+        if (pending) {
+            const bool downsampleDeleted = inherited & INHERIT_DOWNSAMPLE_DELETED;
+            treeDownsampleDeleted = treeDownsampleDeleted || downsampleDeleted;
+            view.treeDeleted = (inherited & INHERIT_TREE_DELETED) || treeDownsampleDeleted;
+            view.pointDeleted = view.treeDeleted || root->point_downsample_deleted || downsampleDeleted;
         }
-        
-        int kFound = qMin(kNearest, q.size());
-        nearestPoints.clear();
-        pointDistance.clear();
-        
-        for (int i = 0; i < kFound; i++) {
-            nearestPoints.prepend(q.top().point);
-            pointDistance.prepend(q.top().dist);
-            q.pop();
+        // 下推后的节点对两侧都带有下推标记，因此继承一旦开始便一直传到叶子
+        const quint8 state = INHERIT_PENDING | (view.treeDeleted ? INHERIT_TREE_DELETED : 0)
+                           | (treeDownsampleDeleted ? INHERIT_DOWNSAMPLE_DELETED : 0);
+        view.leftInherited = pending || root->need_push_down_to_left ? state : quint8(INHERIT_NONE);
+        view.rightInherited = pending || root->need_push_down_to_right ? state : quint8(INHERIT_NONE);
+        return view;
+    }
+    
+    /**
+     * @brief update()合并用的单位元 - 以取地址代替按子节点组合和删除标志的分支
+     */
+    struct MERGE_IDENTITY
+    {
+        KD_TREE_NODE son;       ///< 空子节点：上下界颠倒的无穷包围盒、计数为0、删除标志为真
+        PointType lowPoint;     ///< 三轴均为+inf，下界取min的单位元
+        PointType highPoint;    ///< 三轴均为-inf，上界取max的单位元
+    };
+    
+    static const MERGE_IDENTITY& mergeIdentity()
+    {
+        static const MERGE_IDENTITY identity = [] {
+            constexpr Scalar INF = std::numeric_limits<Scalar>::infinity();
+            MERGE_IDENTITY id;
+            id.son.node_range_x[0] = id.son.node_range_y[0] = id.son.node_range_z[0] = INF;
+            id.son.node_range_x[1] = id.son.node_range_y[1] = id.son.node_range_z[1] = -INF;
+            id.son.point_deleted = id.son.tree_deleted = true;
+            id.son.point_downsample_deleted = id.son.tree_downsample_deleted = true;
+            id.son.TreeSize = 0;
+            id.lowPoint.x = id.lowPoint.y = id.lowPoint.z = INF;
+            id.highPoint.x = id.highPoint.y = id.highPoint.z = -INF;
+            return id;
+        }();
+        return identity;
+    }
+    
+    /**
+     * @brief 判断节点是否为待后台重建的子树根
+     * 
+     * 单线程策略下恒为false，所有依赖重建状态的加锁分支在编译期消除
+     */
+    bool isRebuildTarget(NodeIndex index) const
+    {
+        if constexpr (ThreadPolicy::kMultiThread) {
+            return index != NULL_NODE && m_rebuildTarget.loadAcquire() == index;
+        } else {
+            Q_UNUSED(index);
+            return false;
         }
     }
-
-    void search(KD_TREE_NODE* root, int kNearest, const PointType& point, MANUAL_HEAP& q, double maxDist) {
+    
+    /**
+     * @brief 后台重建是否适用于当前配置
+     * 
+     * 叶块、叶桶、编号映射和区域写分区在构建时会改写树外的共享表，这些配置下重建始终同步完成。
+     * m_snapshot只表示本树自身是只读快照；原树存在快照时仍可后台重建：重建任务不持树锁时只写入专属块，
+     * 快照不共享这些块，重建任务和写者写入共享块时在块分离互斥锁下写时复制
+     */
+    bool backgroundRebuildAllowed() const
+    {
+        const bool hasLeafBlocks = m_leafBlocks.size() > m_freeLeafBlocks.size() + 1;
+        return !m_snapshot && m_writerPartitionDepth.loadRelaxed() == 0 && !m_pointIdTracking
+            && m_compressedLeafSize <= 1 && m_leafBucketSize <= 1 && !hasLeafBlocks;
+    }
+    
+    /**
+     * @brief 请求后台重建子树 - 调用者持有写锁
+     * 
+     * 已有待重建目标时保留较大的一个；重建任务正在执行时放弃本次请求，判据仍不满足时之后的修改会再次请求
+     * @return 子树已交给后台处理或本次放弃时为true；执行器未启用时为false，调用者同步重建
+     */
+    bool requestBackgroundRebuild(NodeIndex index)
+    {
         /**
-         * @brief K近邻搜索核心算法实现
+         * @brief 请求后台重建实现 - 每棵树同时最多一个重建任务，任务在目标清空前持续执行
          */
-        if (root == nullptr || root->tree_deleted) return;
-        
-        double curDist = calcBoxDist(root, point);
-        double maxDistSqr = maxDist * maxDist;
-        if (curDist > maxDistSqr) return;
-        
-        if (root->need_push_down_to_left || root->need_push_down_to_right) {
-            QMutexLocker pushLocker(&root->push_down_mutex);
-            if (pushLocker.mutex()->tryLock()) {
-                pushDown(root);
-                pushLocker.unlock();
-            } else {
-                pushLocker.unlock();
-                QMutexLocker waitLocker(&root->push_down_mutex);
-            }
+        if (!backgroundRebuildAllowed()) return false;
+        QMutexLocker taskLocker(&m_rebuildTaskMutex);
+        if (!m_rebuildTaskPending) {
+            if (!KD_TREE_REBUILD_EXECUTOR::submit([this]() { this->backgroundRebuildTask(); })) return false;
+            m_rebuildTaskPending = true;
         }
-        
-        if (!root->point_deleted) {
-            double dist = calcDist(point, root->point);
-            if (dist <= maxDistSqr && (q.size() < kNearest || dist < q.top().dist)) {
-                if (q.size() >= kNearest) q.pop();
-                PointType_CMP currentPoint{root->point, dist};
-                q.push(currentPoint);
+        if (m_rebuildPtrMutex.tryLock()) {
+            const NodeIndex current = m_rebuildTarget.loadAcquire();
+            if (current == NULL_NODE || node(index)->TreeSize > node(current)->TreeSize) {
+                m_rebuildTarget.storeRelease(index);
             }
+            m_rebuildPtrMutex.unlock();
         }
-        
-        double distLeftNode = calcBoxDist(root->left_son_ptr, point);
-        double distRightNode = calcBoxDist(root->right_son_ptr, point);
-        
-        if (q.size() < kNearest || distLeftNode < q.top().dist && distRightNode < q.top().dist) {
-            if (distLeftNode <= distRightNode) {
-                if (m_rebuildPtr == nullptr || *m_rebuildPtr != root->left_son_ptr) {
-                    search(root->left_son_ptr, kNearest, point, q, maxDist);
-                } else {
-                    QMutexLocker searchLocker(&m_searchFlagMutex);
-                    while (m_searchMutexCounter.loadRelaxed() == -1) {
-                        searchLocker.unlock();
-                        QThread::usleep(1);
-                        searchLocker.relock();
-                    }
-                    m_searchMutexCounter.fetchAndAddRelaxed(1);
-                    searchLocker.unlock();
-                    search(root->left_son_ptr, kNearest, point, q, maxDist);
-                    searchLocker.relock();
-                    m_searchMutexCounter.fetchAndSubRelaxed(1);
-                }
-                
-                if (q.size() < kNearest || distRightNode < q.top().dist) {
-                    if (m_rebuildPtr == nullptr || *m_rebuildPtr != root->right_son_ptr) {
-                        search(root->right_son_ptr, kNearest, point, q, maxDist);
-                    } else {
-                        QMutexLocker searchLocker(&m_searchFlagMutex);
-                        while (m_searchMutexCounter.loadRelaxed() == -1) {
-                            searchLocker.unlock();
-                            QThread::usleep(1);
-                            searchLocker.relock();
-                        }
-                        m_searchMutexCounter.fetchAndAddRelaxed(1);
-                        searchLocker.unlock();
-                        search(root->right_son_ptr, kNearest, point, q, maxDist);
-                        searchLocker.relock();
-                        m_searchMutexCounter.fetchAndSubRelaxed(1);
-                    }
-                }
-            } else {
-                if (m_rebuildPtr == nullptr || *m_rebuildPtr != root->right_son_ptr) {
-                    search(root->right_son_ptr, kNearest, point, q, maxDist);
-                } else {
-                    QMutexLocker searchLocker(&m_searchFlagMutex);
-                    while (m_searchMutexCounter.loadRelaxed() == -1) {
-                        searchLocker.unlock();
-                        QThread::usleep(1);
-                        searchLocker.relock();
-                    }
-                    m_searchMutexCounter.fetchAndAddRelaxed(1);
-                    searchLocker.unlock();
-                    search(root->right_son_ptr, kNearest, point, q, maxDist);
-                    searchLocker.relock();
-                    m_searchMutexCounter.fetchAndSubRelaxed(1);
-                }
-                
-                if (q.size() < kNearest || distLeftNode < q.top().dist) {
-                    if (m_rebuildPtr == nullptr || *m_rebuildPtr != root->left_son_ptr) {
-                        search(root->left_son_ptr, kNearest, point, q, maxDist);
-                    } else {
-                        QMutexLocker searchLocker(&m_searchFlagMutex);
-                        while (m_searchMutexCounter.loadRelaxed() == -1) {
-                            searchLocker.unlock();
-                            QThread::usleep(1);
-                            searchLocker.relock();
-                        }
-                        m_searchMutexCounter.fetchAndAddRelaxed(1);
-                        searchLocker.unlock();
-                        search(root->left_son_ptr, kNearest, point, q, maxDist);
-                        searchLocker.relock();
-                        m_searchMutexCounter.fetchAndSubRelaxed(1);
-                    }
-                }
-            }
-        } else {
-            if (distLeftNode < q.top().dist) {
-                if (m_rebuildPtr == nullptr || *m_rebuildPtr != root->left_son_ptr) {
-                    search(root->left_son_ptr, kNearest, point, q, maxDist);
-                } else {
-                    QMutexLocker searchLocker(&m_searchFlagMutex);
-                    while (m_searchMutexCounter.loadRelaxed() == -1) {
-                        searchLocker.unlock();
-                        QThread::usleep(1);
-                        searchLocker.relock();
-                    }
-                    m_searchMutexCounter.fetchAndAddRelaxed(1);
-                    searchLocker.unlock();
-                    search(root->left_son_ptr, kNearest, point, q, maxDist);
-                    searchLocker.relock();
-                    m_searchMutexCounter.fetchAndSubRelaxed(1);
-                }
-            }
-            if (distRightNode < q.top().dist) {
-                if (m_rebuildPtr == nullptr || *m_rebuildPtr != root->right_son_ptr) {
-                    search(root->right_son_ptr, kNearest, point, q, maxDist);
-                } else {
-                    QMutexLocker searchLocker(&m_searchFlagMutex);
-                    while (m_searchMutexCounter.loadRelaxed() == -1) {
-                        searchLocker.unlock();
-                        QThread::usleep(1);
-                        searchLocker.relock();
-                    }
-                    m_searchMutexCounter.fetchAndAddRelaxed(1);
-                    searchLocker.unlock();
-                    search(root->right_son_ptr, kNearest, point, q, maxDist);
-                    searchLocker.relock();
-                    m_searchMutexCounter.fetchAndSubRelaxed(1);
-                }
+        return true;
+    }
+    
+    /**
+     * @brief 取消尚未开始的后台重建 - 重建任务正在执行时不做处理
+     */
+    void cancelBackgroundRebuild(NodeIndex index)
+    {
+        if (!m_rebuildPtrMutex.tryLock()) return;
+        if (m_rebuildTarget.loadAcquire() == index) m_rebuildTarget.storeRelease(NULL_NODE);
+        m_rebuildPtrMutex.unlock();
+    }
+    
+    /**
+     * @brief 丢弃尚未开始的后台重建并等待重建任务结束 - 调用者不能持有树锁
+     * 
+     * 整树替换、改变后台重建适用条件的设置和析构前调用
+     */
+    void finishBackgroundRebuild()
+    {
+        if constexpr (ThreadPolicy::kMultiThread) {
+            {
+                QMutexLocker rebuildLocker(&m_rebuildPtrMutex);
+                m_rebuildTarget.storeRelease(NULL_NODE);
             }
+            QMutexLocker taskLocker(&m_rebuildTaskMutex);
+            while (m_rebuildTaskPending) m_rebuildTaskIdle.wait(&m_rebuildTaskMutex);
         }
     }
-
-    void addByPoint(KD_TREE_NODE** root, const PointType& point, bool allowRebuild, int fatherAxis) {
+    
+    /**
+     * @brief 重建任务主体 - 在执行器线程上依次重建目标，直到没有目标
+     */
+    void backgroundRebuildTask()
+    {
+        QMutexLocker taskLocker(&m_rebuildTaskMutex);
+        while (m_rebuildTarget.loadAcquire() != NULL_NODE) {
+            taskLocker.unlock();
+            runBackgroundRebuild();
+            taskLocker.relock();
+        }
+        m_rebuildTaskPending = false;
+        m_rebuildTaskIdle.wakeAll();
+    }
+    
+    /**
+     * @brief 后台重建一个子树
+     * 
+     * 持读锁只读平铺目标子树并置位重建标志，此时没有写者，之后对目标的修改都进入重建日志；
+     * 不持树锁构建新子树并补放日志，写者继续修改原子树，查询看到的仍是原子树；
+     * 最后持写锁补放剩余日志，把新子树接入原树并更新祖先，释放写锁后回收原子树
+     */
+    void runBackgroundRebuild()
+    {
         /**
-         * @brief 按点添加实现 - 添加单个点到树中
+         * @brief 后台重建实现 - 全程持有重建目标互斥锁，写者不能更换目标或开始新的重建
          */
-        if (*root == nullptr) {
-            *root = new KD_TREE_NODE;
-            initTreeNode(*root);
-            (*root)->point = point;
-            (*root)->division_axis = (fatherAxis + 1) % 3;
-            update(*root);
-            return;
+        QMutexLocker rebuildLocker(&m_rebuildPtrMutex);
+        const NodeIndex target = m_rebuildTarget.loadAcquire();
+        if (target == NULL_NODE) return;
+        
+        NodeIndex fatherIdx = NULL_NODE;
+        PointVector rebuildStorage;
+        {
+            ReadLocker treeLocker(&m_treeLock);
+            Q_ASSERT(m_rebuildLogger.empty());
+            fatherIdx = node(target)->father_idx;
+            collectPoints(target, inheritedDeleteState(target), rebuildStorage);
+            m_rebuildFlag.storeRelease(1);
         }
         
-        (*root)->working_flag = true;
-        Operation_Logger_Type addLog;
-        addLog.op = ADD_POINT;
-        addLog.point = point;
-        pushDown(*root);
+        NodeIndex newRootNode = NULL_NODE;
+        // 不持树锁回放时每10条让出一次CPU；持写锁回放时不让出，以免阻塞所有读写者
+        auto replayLog = [&](bool yield) {
+            QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
+            int tmpCounter = 0;
+            while (!m_rebuildLogger.empty()) {
+                Operation_Logger_Type operation = m_rebuildLogger.front();
+                m_maxQueueSize = qMax(m_maxQueueSize, m_rebuildLogger.size());
+                m_rebuildLogger.pop();
+                loggerLocker.unlock();
+                runOperation(&newRootNode, operation);
+                tmpCounter++;
+                if (yield && tmpCounter % 10 == 0) QThread::usleep(1);
+                loggerLocker.relock();
+            }
+        };
         
-        // 根据分割轴决定添加方向
-        bool goLeft = false;
-        if ((*root)->division_axis == 0) {
-            goLeft = (point.x < (*root)->point.x);
-        } else if ((*root)->division_axis == 1) {
-            goLeft = (point.y < (*root)->point.y);
-        } else {
-            goLeft = (point.z < (*root)->point.z);
+        // 新子树只写入专属块，同时创建的快照不共享这些块
+        m_nodePool.beginOwnedAllocation();
+        if (!rebuildStorage.isEmpty()) {
+            buildTree(&newRootNode, 0, rebuildStorage.size() - 1, rebuildStorage);
         }
+        replayLog(true);
         
-        if (goLeft) {
-            if ((m_rebuildPtr == nullptr) || (*root)->left_son_ptr != *m_rebuildPtr) {
-                addByPoint(&(*root)->left_son_ptr, point, allowRebuild, (*root)->division_axis);
-            } else {
-                QMutexLocker workingLocker(&m_workingFlagMutex);
-                addByPoint(&(*root)->left_son_ptr, point, false, (*root)->division_axis);
-                if (m_rebuildFlag.loadRelaxed()) {
-                    QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                    m_rebuildLogger.push(addLog);
-                }
-            }
+        WriteLocker treeLocker(&m_treeLock);
+        replayLog(false);
+        m_rebuildFlag.storeRelease(0);
+        
+        // 根节点的father_idx可能为空，按m_rootNode判断目标是否为整棵树
+        if (target == m_rootNode) {
+            m_rootNode = newRootNode;
+            if (m_staticRootNode != NULL_NODE) node(m_staticRootNode)->left_son_idx = m_rootNode;
         } else {
-            if ((m_rebuildPtr == nullptr) || (*root)->right_son_ptr != *m_rebuildPtr) {
-                addByPoint(&(*root)->right_son_ptr, point, allowRebuild, (*root)->division_axis);
+            KD_TREE_NODE* fatherNode = node(fatherIdx);
+            if (fatherNode->left_son_idx == target) {
+                fatherNode->left_son_idx = newRootNode;
+            } else if (fatherNode->right_son_idx == target) {
+                fatherNode->right_son_idx = newRootNode;
             } else {
-                QMutexLocker workingLocker(&m_workingFlagMutex);
-                addByPoint(&(*root)->right_son_ptr, point, false, (*root)->division_axis);
-                if (m_rebuildFlag.loadRelaxed()) {
-                    QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                    m_rebuildLogger.push(addLog);
-                }
+                qCritical() << u8"错误: 父指针与当前节点不兼容";
             }
         }
+        if (newRootNode != NULL_NODE) node(newRootNode)->father_idx = fatherIdx;
         
-        update(*root);
-        
-        if (m_rebuildPtr != nullptr && *m_rebuildPtr == *root && 
-            (*root)->TreeSize < MULTI_THREAD_REBUILD_POINT_NUM) {
-            m_rebuildPtr = nullptr;
-        }
-        
-        bool needRebuild = allowRebuild && criterionCheck(*root);
-        if (needRebuild) {
-            rebuild(root);
+        // 祖先对路径上的子节点仍有未下推的标记时停止，与写线程回溯时的更新条件一致
+        NodeIndex updateRoot = newRootNode != NULL_NODE ? newRootNode : fatherIdx;
+        while (updateRoot != NULL_NODE && updateRoot != m_staticRootNode) {
+            update(updateRoot);
+            if (updateRoot == m_rootNode) break;
+            const NodeIndex updateFatherIdx = node(updateRoot)->father_idx;
+            const KD_TREE_NODE* updateFather = node(updateFatherIdx);
+            if (updateFather == nullptr) break;
+            if (updateFather->left_son_idx == updateRoot && updateFather->need_push_down_to_left) break;
+            if (updateFather->right_son_idx == updateRoot && updateFather->need_push_down_to_right) break;
+            updateRoot = updateFatherIdx;
         }
         
-        if ((*root) != nullptr) {
-            (*root)->working_flag = false;
+        m_rebuildTarget.storeRelease(NULL_NODE);
+        m_nodePool.endOwnedAllocation();
+        // 写者复制共享块时可能释放旧块，原子树须在写锁内回收
+        releaseDetachedTree(target);
+    }
+    
+    /**
+     * @brief 节点从祖先继承的删除状态 - 自根向下按deleteView推导，不写节点
+     */
+    quint8 inheritedDeleteState(NodeIndex index) const
+    {
+        QVarLengthArray<NodeIndex, 64> path;
+        collectAncestors(index, path);
+        quint8 inherited = INHERIT_NONE;
+        for (int i = path.size() - 1; i >= 0; i--) {
+            const KD_TREE_NODE* ancestor = node(path[i]);
+            const DELETE_VIEW view = deleteView(ancestor, inherited);
+            const NodeIndex next = i > 0 ? path[i - 1] : index;
+            inherited = ancestor->left_son_idx == next ? view.leftInherited : view.rightInherited;
         }
+        return inherited;
     }
 
-    void deleteByPoint(KD_TREE_NODE** root, const PointType& point, bool allowRebuild) {
-        /**
-         * @brief 按点删除实现 - 删除指定点
-         */
-        if ((*root) == nullptr || (*root)->tree_deleted) return;
+    struct SNAPSHOT_TAG {};                     ///< 区分快照构造函数的标签
+    
+    /**
+     * @brief 快照构造函数 - 共享source的节点块，复制根节点、叶块表和查询用到的参数，快照不做后台重建
+     */
+    KD_TREE(const KD_TREE& source, SNAPSHOT_TAG)
+        : m_rebuildFlag(0), m_rebuildTarget(NULL_NODE)
+    {
+        m_nodePool.shareFrom(source.m_nodePool);
+        m_leafBlocks = source.m_leafBlocks;
+        m_rootNode = source.m_rootNode;
+        m_deleteCriterionParam = source.m_deleteCriterionParam;
+        m_balanceCriterionParam = source.m_balanceCriterionParam;
+        m_downsampleSize = source.m_downsampleSize;
+        m_compressedLeafSize = source.m_compressedLeafSize;
+        m_compressedResolution = source.m_compressedResolution;
+        m_leafBucketSize = source.m_leafBucketSize;
+        m_splitPlanePruning = source.m_splitPlanePruning;
+        m_rootAlphaDel = source.m_rootAlphaDel;
+        m_rootAlphaBal = source.m_rootAlphaBal;
+        m_snapshot = true;
+    }
+
+public:
+    // 公有成员变量
+    PointVector m_pclStorage;                  ///< 点云存储向量
+    NodeIndex m_rootNode = NULL_NODE;          ///< 根节点索引
+    int m_maxQueueSize = 0;                    ///< 最大队列大小记录
+    // 用于论文数据记录，仅对根节点有意义
+    double m_rootAlphaDel = 0.0;               ///< 根节点删除平衡因子
+    double m_rootAlphaBal = 0.5;               ///< 根节点结构平衡因子
+    
+    /**
+     * @brief 构造函数 - 初始化ikd-Tree
+     * @param deleteParam 删除判据参数
+     * @param balanceParam 平衡判据参数  
+     * @param boxLength 下采样包围盒边长
+     */
+    explicit KD_TREE(double deleteParam = 0.5, double balanceParam = 0.6, double boxLength = 0.2)
+        : m_rebuildFlag(0), m_rebuildTarget(NULL_NODE)
+    {
+        /**
+         * @brief 构造函数实现 - 初始化ikd-Tree所有参数
+         */
+        m_deleteCriterionParam = deleteParam;
+        m_balanceCriterionParam = balanceParam;
+        m_downsampleSize = boxLength;
+        m_rebuildLogger.clear();
+        
+        qDebug() << u8"ikd-Tree Qt版本初始化完成" 
+                 << u8"删除参数:" << deleteParam 
+                 << u8"平衡参数:" << balanceParam;
+    }
+    
+    /**
+     * @brief 析构函数实现 - 清理所有资源
+     */
+    ~KD_TREE()
+    {
+        if constexpr (ThreadPolicy::kMultiThread) {
+            finishBackgroundRebuild();
+        }
+        if (!m_snapshot) {
+            m_deleteStorageDisabled = true;
+            deleteTreeNodes(&m_rootNode);
+        }
+        m_pclStorage.clear();
+        m_rebuildLogger.clear();
+        
+        qDebug() << u8"ikd-Tree Qt版本资源清理完成";
+    }
+    
+    /**
+     * @brief 设置删除判据参数
+     */
+    void setDeleteCriterionParam(double deleteParam)
+    {
+        /**
+         * @brief 设置删除判据参数实现
+         */
+        WriteLocker treeLocker(&m_treeLock);
+        QMutexLocker locker(&m_workingFlagMutex);
+        m_deleteCriterionParam = deleteParam;
+    }
+    
+    /**
+     * @brief 设置平衡判据参数
+     */
+    void setBalanceCriterionParam(double balanceParam)
+    {
+        /**
+         * @brief 设置平衡判据参数实现
+         */
+        WriteLocker treeLocker(&m_treeLock);
+        QMutexLocker locker(&m_workingFlagMutex);
+        m_balanceCriterionParam = balanceParam;
+    }
+    
+    /**
+     * @brief 设置下采样参数
+     */
+    void setDownsampleParam(double downsampleParam)
+    {
+        /**
+         * @brief 设置下采样参数实现
+         */
+        WriteLocker treeLocker(&m_treeLock);
+        QMutexLocker locker(&m_workingFlagMutex);
+        m_downsampleSize = downsampleParam;
+    }
+    
+    /**
+     * @brief 设置压缩叶块参数
+     * 
+     * leafSize大于1时，构建、插入和删除的坐标先对齐到resolution网格（每轴误差不超过resolution/2），
+     * 构建和重建产生的不超过leafSize个点、各轴跨度不超过65534个网格的子树以16位偏移存放为一个叶块。
+     * 叶块仅保留坐标和data成员；插入或局部删除触及叶块时先将其解冻为普通节点。
+     * 应在build()之前设置，设为0关闭压缩
+     * @param leafSize 叶块最大点数，建议16~64
+     * @param resolution 量化分辨率，默认1毫米
+     */
+    void setCompressedLeafSize(int leafSize, double resolution = 0.001)
+    {
+        /**
+         * @brief 设置压缩叶块参数实现
+         */
+        finishBackgroundRebuild();
+        WriteLocker treeLocker(&m_treeLock);
+        QMutexLocker locker(&m_workingFlagMutex);
+        m_compressedLeafSize = qBound(0, leafSize, 65535);
+        if (resolution > 0) m_compressedResolution = resolution;
+    }
+    
+    /**
+     * @brief 获取压缩叶块大小
+     */
+    int compressedLeafSize() const
+    {
+        ReadLocker treeLocker(&m_treeLock);
+        return m_compressedLeafSize;
+    }
+    
+    /**
+     * @brief 将点对齐到压缩叶块量化网格，与构建、插入和删除对输入点的处理相同；未开启压缩叶块时不变
+     * @param points 待对齐的点，原地修改
+     */
+    void snapToLeafGrid(PointVector& points) const
+    {
+        ReadLocker treeLocker(&m_treeLock);
+        if (m_compressedLeafSize <= 1) return;
+        for (PointType& point : points) snapToGrid(point);
+    }
+    
+    /**
+     * @brief 设置精确叶桶大小
+     * 
+     * bucketSize大于1时，构建和重建产生的不超过bucketSize个点的子树存为一个叶桶，坐标不做量化，
+     * 按分量连续存放以便向量化计算距离。插入落入未删除且未满的叶桶时直接追加，局部删除时先解冻为普通节点。
+     * 叶桶仅保留坐标和data成员；与压缩叶块同时开启时以压缩叶块为准。应在build()之前设置，设为0关闭
+     * @param bucketSize 叶桶最大点数，建议16~32
+     */
+    void setLeafBucketSize(int bucketSize)
+    {
+        /**
+         * @brief 设置精确叶桶大小实现
+         */
+        finishBackgroundRebuild();
+        WriteLocker treeLocker(&m_treeLock);
+        QMutexLocker locker(&m_workingFlagMutex);
+        m_leafBucketSize = qBound(0, bucketSize, 65535);
+    }
+    
+    /**
+     * @brief 获取精确叶桶大小
+     */
+    int leafBucketSize() const
+    {
+        ReadLocker treeLocker(&m_treeLock);
+        return m_leafBucketSize;
+    }
+    
+    /**
+     * @brief 设置K近邻搜索的剪枝方式
+     * 
+     * 默认按左右子节点的紧包围盒剪枝，决定下降顺序前需读取两个子节点。开启后改为沿路径增量维护
+     * 查询点到当前单元各分割面的偏移（Arya-Mount），远侧子节点在读取其内存之前即可按分割面距离排除，
+     * 进入节点后再以该节点自身的包围盒补充剪枝。两种方式结果相同
+     * @param enabled 是否按分割面剪枝
+     */
+    void setSplitPlanePruning(bool enabled)
+    {
+        WriteLocker treeLocker(&m_treeLock);
+        m_splitPlanePruning = enabled;
+    }
+    
+    /**
+     * @brief 获取是否按分割面剪枝
+     */
+    bool splitPlanePruning() const
+    {
+        ReadLocker treeLocker(&m_treeLock);
+        return m_splitPlanePruning;
+    }
+    
+    /**
+     * @brief 设置区域写分区深度
+     * 
+     * depth大于0时，addPoints()、deletePoints()和deletePointBoxes()以区域写模式加锁：这三类修改之间可以并发，
+     * 与查询及其他修改仍然互斥。根以下depth层的节点为上层节点，其下至多2^depth棵子树各为一个分区，
+     * 各自由一把互斥锁保护，落在不同分区的修改并行执行，跨分区或涉及上层节点自身点的操作按分区序号
+     * 依次加锁。会话期间上层节点的统计信息和重建判据延后到最后一个区域写者离开时处理，分区内的重建照常进行。
+     * 开启叶块、叶桶或编号映射时这三类修改仍互相串行。设为0关闭，最大MAX_WRITER_PARTITION_DEPTH
+     * @param depth 分区深度，建议取log2(写线程数)+2
+     */
+    void setWriterPartitionDepth(int depth)
+    {
+        finishBackgroundRebuild();
+        WriteLocker treeLocker(&m_treeLock);
+        m_writerPartitionDepth.storeRelaxed(qBound(0, depth, int(MAX_WRITER_PARTITION_DEPTH)));
+    }
+    
+    /**
+     * @brief 获取区域写分区深度
+     */
+    int writerPartitionDepth() const
+    {
+        ReadLocker treeLocker(&m_treeLock);
+        return m_writerPartitionDepth.loadRelaxed();
+    }
+    
+    /**
+     * @brief 设置是否维护点编号映射
+     * 
+     * 开启后以点的data成员作为稳定编号（要求为整数类型、取值唯一且较为稠密），
+     * 构建、重建和插入时记录每个编号所在的节点，deletePointById()据此直接定位节点，
+     * 无需按坐标下降查找。应在build()之前设置
+     */
+    void setPointIdTracking(bool enabled)
+    {
+        /**
+         * @brief 设置点编号映射实现
+         */
+        static_assert(std::is_integral_v<PayloadType>, "点编号映射要求data成员为整数类型");
+        finishBackgroundRebuild();
+        WriteLocker treeLocker(&m_treeLock);
+        QMutexLocker locker(&m_workingFlagMutex);
+        m_pointIdTracking = enabled;
+        if (!enabled) m_pointIdNodes.clear();
+    }
+    
+    /**
+     * @brief 重新初始化K-D树参数
+     */
+    void initializeKdTree(double deleteParam = 0.5, double balanceParam = 0.7, double boxLength = 0.2)
+    {
+        /**
+         * @brief 重新初始化K-D树参数实现
+         */
+        setDeleteCriterionParam(deleteParam);
+        setBalanceCriterionParam(balanceParam);
+        setDownsampleParam(boxLength);
+    }
+    
+    /**
+     * @brief 获取树大小 - 线程安全版本
+     */
+    int size() const
+    {
+        /**
+         * @brief 获取树大小实现 - 线程安全版本
+         */
+        ReadLocker treeLocker(&m_treeLock);
+        return m_rootNode != NULL_NODE ? node(m_rootNode)->TreeSize : 0;
+    }
+    
+    /**
+     * @brief 获取有效节点数
+     */
+    int validnum() const
+    {
+        /**
+         * @brief 获取有效节点数实现
+         */
+        ReadLocker treeLocker(&m_treeLock);
+        return m_rootNode != NULL_NODE ? node(m_rootNode)->TreeSize - node(m_rootNode)->invalid_point_num : 0;
+    }
+    
+    /**
+     * @brief 创建只读快照
+     * 
+     * 快照与树共享节点内存池的块，创建时只复制块表并增加各块的引用计数，不复制节点。
+     * 此后树的修改写入仍被共享的块前先复制该块，快照看到的始终是创建时的状态；
+     * 最后一个指向快照的智能指针释放时，只被快照持有的块随之回收。
+     * 快照只提供查询方法，可在任意线程使用，与原树的读写互不阻塞；正在执行的后台重建只在替换子树时短暂阻塞创建
+     * @return 只读快照
+     */
+    ConstPtr snapshot() const
+    {
+        /**
+         * @brief 创建只读快照实现 - 持有读锁，期间没有写线程修改块表；后台重建任务此时只写入专属块，
+         * 快照不共享专属块，不必等待重建结束
+         */
+        ReadLocker treeLocker(&m_treeLock);
+        return ConstPtr(new KD_TREE(*this, SNAPSHOT_TAG()));
+    }
+    
+    /**
+     * @brief 仍与快照共享的节点块占用的字节数，没有存活快照时为0
+     */
+    qint64 sharedNodeBytes() const
+    {
+        ReadLocker treeLocker(&m_treeLock);
+        return m_nodePool.sharedBytes();
+    }
+    
+    /**
+     * @brief 获取树范围 - 返回整个树的包围盒
+     */
+    BoxType treeRange() const
+    {
+        /**
+         * @brief 获取树范围实现 - 返回整个树的包围盒
+         */
+        ReadLocker treeLocker(&m_treeLock);
+        BoxType range;
+        if (m_rootNode != NULL_NODE) {
+            range.vertex_min[0] = node(m_rootNode)->node_range_x[0];
+            range.vertex_min[1] = node(m_rootNode)->node_range_y[0];
+            range.vertex_min[2] = node(m_rootNode)->node_range_z[0];
+            range.vertex_max[0] = node(m_rootNode)->node_range_x[1];
+            range.vertex_max[1] = node(m_rootNode)->node_range_y[1];
+            range.vertex_max[2] = node(m_rootNode)->node_range_z[1];
+        }
+        return range;
+    }
+    
+    /**
+     * @brief 获取平衡因子和删除因子
+     */
+    void rootAlpha(double& alphaBal, double& alphaDel) const
+    {
+        /**
+         * @brief 获取根节点平衡因子实现
+         */
+        ReadLocker treeLocker(&m_treeLock);
+        alphaBal = m_rootAlphaBal;
+        alphaDel = m_rootAlphaDel;
+    }
+    
+    /**
+     * @brief 构建K-D树
+     */
+    void build(const PointVector& pointCloud)
+    {
+        /**
+         * @brief 构建K-D树实现 - 从点云数据构建完整的树，先丢弃待执行的后台重建
+         */
+        finishBackgroundRebuild();
+        WriteLocker treeLocker(&m_treeLock);
+        if (m_rootNode != NULL_NODE) {
+            deleteTreeNodes(&m_rootNode);
+        }
+        if (pointCloud.size() == 0) return;
+        
+        if (m_staticRootNode != NULL_NODE) {
+            m_nodePool.release(m_staticRootNode);
+        }
+        m_staticRootNode = m_nodePool.allocate();
+        initTreeNode(node(m_staticRootNode));
+        
+        // 复制点云数据到临时存储
+        PointVector tempStorage = pointCloud;
+        if (m_compressedLeafSize > 1) {
+            for (PointType& point : tempStorage) snapToGrid(point);
+        }
+        buildTree(&node(m_staticRootNode)->left_son_idx, 0, tempStorage.size()-1, tempStorage);
+        update(m_staticRootNode);
+        node(m_staticRootNode)->TreeSize = 0;
+        m_rootNode = node(m_staticRootNode)->left_son_idx;
+        
+        qDebug() << u8"K-D树构建完成，节点数:" << pointCloud.size();
+    }
+    
+    /**
+     * @brief 包围盒搜索
+     */
+    void boxSearch(const BoxType& boxOfPoint, PointVector& storage) const
+    {
+        /**
+         * @brief 包围盒搜索实现
+         */
+        ReadLocker treeLocker(&m_treeLock);
+        storage.clear();
+        searchByRange(m_rootNode, boxOfPoint, storage);
+    }
+    
+    /**
+     * @brief 半径搜索
+     */
+    void radiusSearch(const PointType& point, double radius, PointVector& storage) const
+    {
+        /**
+         * @brief 半径搜索实现
+         */
+        ReadLocker treeLocker(&m_treeLock);
+        storage.clear();
+        searchByRadius(m_rootNode, point, radius, storage);
+    }
+    
+    /**
+     * @brief 带时限的包围盒搜索 - 时限用尽时返回已找到的点
+     * @return 停止时仍有子树未访问则为true
+     */
+    bool boxSearch(const BoxType& boxOfPoint, PointVector& storage, const SEARCH_LIMIT& limit) const
+    {
+        ReadLocker treeLocker(&m_treeLock);
+        storage.clear();
+        SEARCH_BUDGET budget(limit.maxVisitedNodes, limit.deadline);
+        searchByRange(m_rootNode, boxOfPoint, storage, INHERIT_NONE, &budget);
+        return countLimitedSearch(budget);
+    }
+    
+    /**
+     * @brief 带时限的半径搜索 - 时限用尽时返回已找到的点
+     * @return 停止时仍有子树未访问则为true
+     */
+    bool radiusSearch(const PointType& point, double radius, PointVector& storage, const SEARCH_LIMIT& limit) const
+    {
+        ReadLocker treeLocker(&m_treeLock);
+        storage.clear();
+        SEARCH_BUDGET budget(limit.maxVisitedNodes, limit.deadline);
+        searchByRadius(m_rootNode, point, radius, storage, INHERIT_NONE, &budget);
+        return countLimitedSearch(budget);
+    }
+    
+    /**
+     * @brief 带时限的查询次数，包括K近邻、半径和包围盒搜索
+     */
+    qint64 limitedSearches() const { return m_limitedSearches.loadRelaxed(); }
+    
+    /**
+     * @brief 带时限的查询中被截断的次数
+     */
+    qint64 truncatedSearches() const { return m_truncatedSearches.loadRelaxed(); }
+    
+    /**
+     * @brief 清零带时限查询的计数
+     */
+    void resetSearchCounters()
+    {
+        m_limitedSearches.storeRelaxed(0);
+        m_truncatedSearches.storeRelaxed(0);
+    }
+    
+    /**
+     * @brief K近邻搜索
+     */
+    void nearestSearch(const PointType& point, int kNearest, PointVector& nearestPoints, 
+                      QVector<double>& pointDistance, double maxDist = std::numeric_limits<double>::infinity(),
+                      int* visitedNodes = nullptr) const {
+        /**
+         * @brief K近邻搜索实现 - 搜索K个最近邻点，visitedNodes非空时输出本次进入的节点数
+         */
+        ReadLocker treeLocker(&m_treeLock);
+        SEARCH_BUDGET budget;
+        searchNearest(point, kNearest, nearestPoints, pointDistance, maxDist, visitedNodes, Scalar(1), budget);
+    }
+
+    /**
+     * @brief 近似K近邻搜索 - 按approximate放宽剪枝并限制进入的节点数，其余参数与精确版本相同
+     */
+    void nearestSearch(const PointType& point, int kNearest, PointVector& nearestPoints, QVector<double>& pointDistance,
+                       const APPROXIMATE_SEARCH& approximate, double maxDist = std::numeric_limits<double>::infinity(),
+                       int* visitedNodes = nullptr) const {
+        ReadLocker treeLocker(&m_treeLock);
+        SEARCH_BUDGET budget(approximate.maxVisitedNodes);
+        searchNearest(point, kNearest, nearestPoints, pointDistance, maxDist, visitedNodes,
+                      Scalar(approximate.pruneScale()), budget);
+    }
+
+    /**
+     * @brief 带时限的K近邻搜索 - 时限用尽时返回已找到的近邻
+     * @return 停止时仍有可能改进结果的子树未访问则为true
+     */
+    bool nearestSearch(const PointType& point, int kNearest, PointVector& nearestPoints, QVector<double>& pointDistance,
+                       const SEARCH_LIMIT& limit, double maxDist = std::numeric_limits<double>::infinity(),
+                       int* visitedNodes = nullptr) const {
+        ReadLocker treeLocker(&m_treeLock);
+        SEARCH_BUDGET budget(limit.maxVisitedNodes, limit.deadline);
+        searchNearest(point, kNearest, nearestPoints, pointDistance, maxDist, visitedNodes, Scalar(1), budget);
+        return countLimitedSearch(budget);
+    }
+
+    /**
+     * @brief 批量K近邻搜索
+     * 
+     * 每组BATCH_SEARCH_GROUP个查询轮流推进：一个查询进入一个节点并预取下一个节点后即切换到组内下一个查询，
+     * 单个查询的访存等待由其他查询的计算填充。各查询的访问顺序与nearestSearch相同，结果逐位一致
+     * @param queries 查询点
+     * @param kNearest 近邻数
+     * @param nearestPoints 输出每个查询的近邻点，按距离升序
+     * @param pointDistances 输出对应的距离平方
+     * @param maxDist 最大搜索距离
+     */
+    void nearestSearchBatch(const PointVector& queries, int kNearest, QVector<PointVector>& nearestPoints,
+                            QVector<QVector<double>>& pointDistances,
+                            double maxDist = std::numeric_limits<double>::infinity()) const
+    {
+        nearestSearchBatch(queries, kNearest, nearestPoints, pointDistances, APPROXIMATE_SEARCH(), maxDist);
+    }
+    
+    /**
+     * @brief 近似批量K近邻搜索 - 每个查询的结果与以同一参数调用近似nearestSearch相同
+     */
+    void nearestSearchBatch(const PointVector& queries, int kNearest, QVector<PointVector>& nearestPoints,
+                            QVector<QVector<double>>& pointDistances, const APPROXIMATE_SEARCH& approximate,
+                            double maxDist = std::numeric_limits<double>::infinity()) const
+    {
+        /**
+         * @brief 批量K近邻搜索实现
+         */
+        ReadLocker treeLocker(&m_treeLock);
+        nearestPoints.resize(queries.size());
+        pointDistances.resize(queries.size());
+        if (m_splitPlanePruning) {
+            searchBatch<SPLIT_FRAME>(queries, kNearest, nearestPoints, pointDistances, maxDist * maxDist, approximate);
+        } else {
+            searchBatch<SEARCH_FRAME>(queries, kNearest, nearestPoints, pointDistances, maxDist * maxDist, approximate);
+        }
+    }
+    
+
+    
+    /**
+     * @brief 添加点集合
+     */
+    int addPoints(PointVector& pointToAdd, bool downsampleOn)
+    {
+        /**
+         * @brief 批量添加点实现 - 支持下采样功能
+         * 
+         * 分区深度为0时持写锁按输入顺序逐点执行。区域写模式下各点按分区分组执行，组内保持输入顺序，
+         * 不同体素的下采样互不影响，分组不改变结果
+         */
+        bool downsampleSwitch = downsampleOn && DOWNSAMPLE_SWITCH;
+        int tmpCounter = 0;
+        PointVector downsampleStorage;
+        
+        if (m_writerPartitionDepth.loadRelaxed() == 0) {
+            WriteLocker treeLocker(&m_treeLock);
+            for (int i = 0; i < pointToAdd.size(); i++) {
+                const PointType point = gridPoint(pointToAdd[i]);
+                if (!downsampleSwitch) {
+                    partitionAddPoint(wholeTreePartition(), point);
+                } else if (downsamplePoint(point, downsampleStorage,
+                               [&](const BoxType& boxOfPoint) { searchByRange(m_rootNode, boxOfPoint, downsampleStorage); },
+                               [&](const BoxType& boxOfPoint) { partitionDeleteBox(wholeTreePartition(), boxOfPoint, true); },
+                               [&](const PointType& result) { partitionAddPoint(wholeTreePartition(), result); })) {
+                    tmpCounter++;
+                }
+            }
+            return tmpCounter;
+        }
+        
+        enterRegion();
+        if (!downsampleSwitch) {
+            runRegionOperations(pointToAdd.size(),
+                [&](int i, REGION_TOUCH& touch) {
+                    touch.partitions.clear();
+                    touch.partitions.append(routePoint(gridPoint(pointToAdd[i])));
+                    touch.upper = false;
+                },
+                [&](int i) {
+                    const PointType point = gridPoint(pointToAdd[i]);
+                    partitionAddPoint(m_regionPartitions[routePoint(point)], point);
+                });
+            leaveRegion();
+            return tmpCounter;
+        }
+        
+        runRegionOperations(pointToAdd.size(),
+            [&](int i, REGION_TOUCH& touch) {
+                BoxType boxOfPoint;
+                PointType midPoint;
+                downsampleBox(gridPoint(pointToAdd[i]), boxOfPoint, midPoint);
+                routeBox(boxOfPoint, [&](const PointType& upperPoint) { return boxContains(boxOfPoint, upperPoint); }, touch);
+            },
+            [&](int i) {
+                if (downsamplePoint(gridPoint(pointToAdd[i]), downsampleStorage,
+                        [&](const BoxType& boxOfPoint) { regionSearchBox(regionRoot(), boxOfPoint, downsampleStorage); },
+                        [&](const BoxType& boxOfPoint) { regionDeleteBox(regionRoot(), boxOfPoint, true); },
+                        [&](const PointType& result) { partitionAddPoint(m_regionPartitions[routePoint(result)], result); })) {
+                    tmpCounter++;
+                }
+            });
+        leaveRegion();
+        return tmpCounter;
+    }
+    
+    /**
+     * @brief 删除点集合
+     */
+    void deletePoints(PointVector& pointToDel)
+    {
+        /**
+         * @brief 批量删除点实现 - 分区深度为0时持写锁逐点执行
+         */
+        if (m_writerPartitionDepth.loadRelaxed() == 0) {
+            WriteLocker treeLocker(&m_treeLock);
+            for (int i = 0; i < pointToDel.size(); i++) {
+                deletePoint(gridPoint(pointToDel[i]));
+            }
+            return;
+        }
+        enterRegion();
+        runRegionOperations(pointToDel.size(),
+            [&](int i, REGION_TOUCH& touch) {
+                const PointType point = gridPoint(pointToDel[i]);
+                routeBox(BoxType(point, point),
+                         [&](const PointType& upperPoint) { return samePoint(upperPoint, point); }, touch);
+            },
+            [&](int i) { regionDeletePoint(regionRoot(), gridPoint(pointToDel[i])); });
+        leaveRegion();
+    }
+    
+    /**
+     * @brief 按编号删除点 - 需先开启setPointIdTracking()
+     * 
+     * 由编号映射直接定位节点，沿父节点链自上而下下推延迟标志后标记删除，再自下而上更新统计并检查重建判据
+     * @return 点存在且此前未被删除时返回true
+     */
+    bool deletePointById(PointId id)
+    {
+        /**
+         * @brief 按编号删除点实现
+         */
+        WriteLocker treeLocker(&m_treeLock);
+        return removePointById(id);
+    }
+    
+    /**
+     * @brief 按编号批量删除点
+     * @param deletedIds 非空时追加实际删除的编号，不存在或此前已删除的编号不输出
+     * @return 实际删除的点数
+     */
+    int deletePointsById(const QVector<PointId>& ids, QVector<PointId>* deletedIds = nullptr)
+    {
+        /**
+         * @brief 按编号批量删除点实现
+         */
+        WriteLocker treeLocker(&m_treeLock);
+        int tmpCounter = 0;
+        for (PointId id : ids) {
+            if (!removePointById(id)) continue;
+            tmpCounter++;
+            if (deletedIds != nullptr) deletedIds->append(id);
+        }
+        return tmpCounter;
+    }
+    
+    /**
+     * @brief 添加包围盒集合
+     */
+    void addPointBoxes(QVector<BoxType>& boxPoints)
+    {
+        /**
+         * @brief 批量添加包围盒实现 - 恢复指定区域内的点
+         */
+        WriteLocker treeLocker(&m_treeLock);
+        for (int i = 0; i < boxPoints.size(); i++) {
+            if (!isRebuildTarget(m_rootNode)) {
+                addByRange(&m_rootNode, boxPoints[i], true);
+            } else {
+                Operation_Logger_Type operation;
+                operation.boxpoint = boxPoints[i];
+                operation.op = ADD_BOX;
+                
+                QMutexLocker workingLocker(&m_workingFlagMutex);
+                addByRange(&m_rootNode, boxPoints[i], false);
+                
+                if (m_rebuildFlag.loadAcquire()) {
+                    QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
+                    m_rebuildLogger.push(operation);
+                }
+            }
+        }
+    }
+    
+    /**
+     * @brief 删除包围盒集合
+     */
+    int deletePointBoxes(QVector<BoxType>& boxPoints)
+    {
+        /**
+         * @brief 批量删除包围盒实现 - 分区深度为0时持写锁逐个执行
+         */
+        int tmpCounter = 0;
+        if (m_writerPartitionDepth.loadRelaxed() == 0) {
+            WriteLocker treeLocker(&m_treeLock);
+            for (int i = 0; i < boxPoints.size(); i++) {
+                tmpCounter += partitionDeleteBox(wholeTreePartition(), boxPoints[i], false);
+            }
+            return tmpCounter;
+        }
+        enterRegion();
+        runRegionOperations(boxPoints.size(),
+            [&](int i, REGION_TOUCH& touch) {
+                routeBox(boxPoints[i], [&](const PointType& upperPoint) { return boxContains(boxPoints[i], upperPoint); }, touch);
+            },
+            [&](int i) { tmpCounter += regionDeleteBox(regionRoot(), boxPoints[i], false); });
+        leaveRegion();
+        return tmpCounter;
+    }
+    
+    /**
+     * @brief 获取已删除的点
+     */
+    void acquireRemovedPoints(PointVector& removedPoints)
+    {
+        /**
+         * @brief 获取已删除点实现
+         */
+        QMutexLocker pointsLocker(&m_pointsDeletedRebuildMutex);
+        for (int i = 0; i < m_pointsDeleted.size(); i++) {
+            removedPoints.append(m_pointsDeleted[i]);
+        }
+        for (int i = 0; i < m_multithreadPointsDeleted.size(); i++) {
+            removedPoints.append(m_multithreadPointsDeleted[i]);
+        }
+        m_pointsDeleted.clear();
+        m_multithreadPointsDeleted.clear();
+    }
+
+private:
+    /**
+     * @brief 进入区域写会话 - 会话打开者下推上层节点的延迟标记并划分分区
+     * 
+     * 上层节点的延迟标记在此一次下推，会话期间区域写操作不在上层节点上做懒标记，
+     * 分区子树根继承的删除状态因此总是为空
+     */
+    void enterRegion()
+    {
+        /**
+         * @brief 进入区域写会话实现 - 串行条件下整棵树为一个分区
+         */
+        if (!m_treeLock.lockForRegion()) return;
+        m_regionUpper.clear();
+        m_regionPartitions.clear();
+        const bool hasLeafBlocks = m_leafBlocks.size() > m_freeLeafBlocks.size() + 1;
+        const bool serial = m_writerPartitionDepth.loadRelaxed() == 0 || m_rootNode == NULL_NODE || m_pointIdTracking
+                         || m_compressedLeafSize > 1 || m_leafBucketSize > 1 || hasLeafBlocks
+                         || isRebuildTarget(m_rootNode);
+        if (serial) {
+            m_regionPartitions.append(wholeTreePartition());
+            m_treeLock.openRegion();
+            return;
+        }
+        
+        struct PARTITION_FRAME
+        {
+            NodeIndex index;    ///< 子树根节点索引
+            int depth;          ///< 深度，根为0
+            int father;         ///< 父上层节点序号，-1表示根
+            int side;           ///< 位于父节点的哪一侧
+        };
+        QVarLengthArray<PARTITION_FRAME, 2 * MAX_WRITER_PARTITION_DEPTH + 2> stack;
+        stack.append(PARTITION_FRAME{m_rootNode, 0, -1, 0});
+        while (!stack.isEmpty()) {
+            const PARTITION_FRAME frame = stack.takeLast();
+            KD_TREE_NODE* root = node(frame.index);
+            qint32 code;
+            if (root != nullptr && root->leaf_idx == 0 && frame.depth < m_writerPartitionDepth.loadRelaxed()) {
+                pushDown(root);
+                code = m_regionUpper.size();
+                m_regionUpper.append(UPPER_NODE{frame.index, {0, 0}});
+                stack.append(PARTITION_FRAME{root->right_son_idx, frame.depth + 1, code, 1});
+                stack.append(PARTITION_FRAME{root->left_son_idx, frame.depth + 1, code, 0});
+            } else {
+                KD_TREE_NODE* father = node(m_regionUpper[frame.father].index);
+                NodeIndex* slot = frame.side == 0 ? &father->left_son_idx : &father->right_son_idx;
+                code = ~qint32(m_regionPartitions.size());
+                m_regionPartitions.append(WRITER_PARTITION{slot, father->division_axis});
+            }
+            if (frame.father >= 0) m_regionUpper[frame.father].son[frame.side] = code;
+        }
+        m_treeLock.openRegion();
+    }
+    
+    /**
+     * @brief 离开区域写会话 - 最后离开者自下而上更新上层节点并检查重建判据
+     */
+    void leaveRegion()
+    {
+        /**
+         * @brief 离开区域写会话实现 - 逆先序即子节点先于父节点，与逐点回溯时的更新顺序一致
+         */
+        if (!m_treeLock.releaseRegion()) return;
+        for (int i = m_regionUpper.size() - 1; i >= 0; i--) {
+            const NodeIndex index = m_regionUpper[i].index;
+            update(index);
+            if (criterionCheck(node(index))) {
+                rebuild(linkSlot(index));
+            }
+        }
+        m_regionUpper.clear();
+        m_regionPartitions.clear();
+        m_treeLock.unlock();
+    }
+    
+    /**
+     * @brief 区域写会话的起点 - 有上层节点时为0号上层节点，否则为0号分区
+     */
+    qint32 regionRoot() const
+    {
+        return m_regionUpper.isEmpty() ? ~qint32(0) : 0;
+    }
+    
+    /**
+     * @brief 在区域写会话中执行一批操作
+     * 
+     * 只涉及单个分区的操作按分区分组，组内保持输入顺序，各组优先挑选未被其他写者占用的分区执行；
+     * 跨分区或涉及上层节点自身点的操作最后逐个执行，按分区序号升序加锁，再加上层节点锁
+     * @param count 操作数
+     * @param route 填写第i个操作涉及的分区
+     * @param run 执行第i个操作
+     */
+    template<typename Route, typename Run>
+    void runRegionOperations(int count, Route route, Run run)
+    {
+        /**
+         * @brief 分组执行实现 - 只有一个分区时按输入顺序执行
+         */
+        if (count == 0) return;
+        if (m_regionPartitions.size() == 1) {
+            QMutexLocker locker(&m_regionMutexes[0]);
+            for (int i = 0; i < count; i++) run(i);
+            return;
+        }
+        
+        // 按分区计数排序，最后一组为跨分区操作
+        const int partitionCount = m_regionPartitions.size();
+        REGION_TOUCH touch;
+        QVector<int> keys(count);
+        QVarLengthArray<int, MAX_WRITER_PARTITIONS + 3> offsets(partitionCount + 3);
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (int i = 0; i < count; i++) {
+            route(i, touch);
+            keys[i] = touch.partitions.size() == 1 && !touch.upper ? touch.partitions[0] : partitionCount;
+            offsets[keys[i] + 2]++;
+        }
+        for (int k = 2; k < offsets.size(); k++) offsets[k] += offsets[k - 1];
+        QVector<int> order(count);
+        for (int i = 0; i < count; i++) order[offsets[keys[i] + 1]++] = i;
+        
+        QVarLengthArray<int, MAX_WRITER_PARTITIONS> pending;
+        for (int p = 0; p < partitionCount; p++) {
+            if (offsets[p + 1] > offsets[p]) pending.append(p);
+        }
+        auto runGroup = [&](int p) {
+            for (int j = offsets[p]; j < offsets[p + 1]; j++) run(order[j]);
+            m_regionMutexes[p].unlock();
+        };
+        while (!pending.isEmpty()) {
+            bool progressed = false;
+            for (int j = 0; j < pending.size();) {
+                if (m_regionMutexes[pending[j]].tryLock()) {
+                    runGroup(pending[j]);
+                    pending[j] = pending.last();
+                    pending.removeLast();
+                    progressed = true;
+                } else {
+                    j++;
+                }
+            }
+            if (!progressed) {
+                m_regionMutexes[pending.last()].lock();
+                runGroup(pending.last());
+                pending.removeLast();
+            }
+        }
+        
+        for (int j = offsets[partitionCount]; j < count; j++) {
+            const int i = order[j];
+            route(i, touch);
+            for (int p : touch.partitions) m_regionMutexes[p].lock();
+            if (touch.upper) m_regionUpperMutex.lock();
+            run(i);
+            if (touch.upper) m_regionUpperMutex.unlock();
+            for (int p : touch.partitions) m_regionMutexes[p].unlock();
+        }
+    }
+    
+    /**
+     * @brief 在区域写会话中按范围搜索 - 上层节点只按分割面下降，包围盒在会话期间可能过时
+     */
+    void regionSearchBox(qint32 code, const BoxType& boxpoint, PointVector& storage) const
+    {
+        if (code < 0) {
+            searchByRange(*m_regionPartitions[~code].slot, boxpoint, storage);
+            return;
+        }
+        const UPPER_NODE& upper = m_regionUpper[code];
+        const KD_TREE_NODE* root = node(upper.index);
+        if (boxContains(boxpoint, root->point) && !root->point_deleted) storage.append(root->point);
+        const int axis = root->division_axis;
+        const Scalar splitValue = axis == 0 ? root->point.x : (axis == 1 ? root->point.y : root->point.z);
+        if (boxpoint.vertex_min[axis] <= splitValue) regionSearchBox(upper.son[0], boxpoint, storage);
+        if (boxpoint.vertex_max[axis] > splitValue) regionSearchBox(upper.son[1], boxpoint, storage);
+    }
+    
+    /**
+     * @brief 在区域写会话中按包围盒删除 - 上层节点只删除自身的点，整体覆盖的懒标记落在分区子树根上
+     */
+    int regionDeleteBox(qint32 code, const BoxType& boxpoint, bool isDownsample)
+    {
+        if (code < 0) return partitionDeleteBox(m_regionPartitions[~code], boxpoint, isDownsample);
+        const UPPER_NODE& upper = m_regionUpper[code];
+        KD_TREE_NODE* root = node(upper.index);
+        int tmpCounter = 0;
+        if (boxContains(boxpoint, root->point) && !root->point_deleted) {
+            root->point_deleted = true;
+            if (isDownsample) root->point_downsample_deleted = true;
+            tmpCounter += 1;
+        }
+        const int axis = root->division_axis;
+        const Scalar splitValue = axis == 0 ? root->point.x : (axis == 1 ? root->point.y : root->point.z);
+        if (boxpoint.vertex_min[axis] <= splitValue) tmpCounter += regionDeleteBox(upper.son[0], boxpoint, isDownsample);
+        if (boxpoint.vertex_max[axis] > splitValue) tmpCounter += regionDeleteBox(upper.son[1], boxpoint, isDownsample);
+        return tmpCounter;
+    }
+    
+    /**
+     * @brief 在区域写会话中按坐标删除点 - 下降方向与deleteByPoint一致，上层节点的计数在会话结束时更新
+     */
+    bool regionDeletePoint(qint32 code, const PointType& point)
+    {
+        if (code < 0) {
+            const WRITER_PARTITION& partition = m_regionPartitions[~code];
+            if (!isRebuildTarget(*partition.slot)) {
+                return deleteByPoint(partition.slot, point, true);
+            }
+            Operation_Logger_Type operation;
+            operation.point = point;
+            operation.op = DELETE_POINT;
+            
+            QMutexLocker workingLocker(&m_workingFlagMutex);
+            bool found = deleteByPoint(partition.slot, point, false);
+            if (m_rebuildFlag.loadAcquire()) {
+                QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
+                m_rebuildLogger.push(operation);
+            }
+            return found;
+        }
+        const UPPER_NODE& upper = m_regionUpper[code];
+        KD_TREE_NODE* root = node(upper.index);
+        if (samePoint(root->point, point) && !root->point_deleted) {
+            root->point_deleted = true;
+            return true;
+        }
+        const int axis = root->division_axis;
+        const Scalar pointValue = axis == 0 ? point.x : (axis == 1 ? point.y : point.z);
+        const Scalar splitValue = axis == 0 ? root->point.x : (axis == 1 ? root->point.y : root->point.z);
+        if (pointValue < splitValue) return regionDeletePoint(upper.son[0], point);
+        bool found = regionDeletePoint(upper.son[1], point);
+        if (!found && pointValue == splitValue) found = regionDeletePoint(upper.son[0], point);
+        return found;
+    }
+    
+    /**
+     * @brief 按编号删除单个点 - 调用者已持有写锁
+     */
+    bool removePointById(PointId id)
+    {
+        /**
+         * @brief 按编号删除单个点实现
+         */
+        static_assert(std::is_integral_v<PayloadType>, "按编号删除要求data成员为整数类型");
+        if (!m_pointIdTracking || int(id) >= m_pointIdNodes.size()) return false;
+        NodeIndex targetIdx = m_pointIdNodes.at(int(id));
+        if (targetIdx == NULL_NODE) return false;
+        
+        KD_TREE_NODE* target = node(targetIdx);
+        if (target->leaf_idx == 0 ? PointId(target->point.data) != id : !leafBlockContainsId(target, id)) {
+            return false;
+        }
+        
+        if (isRebuildTarget(m_rootNode)) {
+            // 后台重建期间按坐标删除，以便记录到重建日志
+            deletePoint(target->leaf_idx == 0 ? target->point : leafBlockPointById(target, id));
+            return true;
+        }
+        
+        // 自根向下补齐父节点链上尚未下推的删除标志
+        QVarLengthArray<NodeIndex, 64> path;
+        collectAncestors(targetIdx, path);
+        for (int i = path.size() - 1; i >= 0; i--) {
+            KD_TREE_NODE* ancestor = node(path[i]);
+            if (ancestor->tree_deleted) return false;
+            pushDown(ancestor);
+        }
+        if (target->tree_deleted) return false;
+        
+        if (target->leaf_idx != 0) {
+            thawLeafBlock(linkSlot(targetIdx));
+            targetIdx = m_pointIdNodes.at(int(id));
+            target = node(targetIdx);
+            collectAncestors(targetIdx, path);
+        }
+        if (target->point_deleted) return false;
+        
+        target->point_deleted = true;
+        target->invalid_point_num += 1;
+        if (target->invalid_point_num == target->TreeSize) {
+            target->tree_deleted = true;
+        }
+        
+        // 自下而上更新，与deleteByPoint回溯时的顺序一致
+        for (int i = 0; i < path.size(); i++) {
+            update(path[i]);
+            KD_TREE_NODE* ancestor = node(path[i]);
+            if (criterionCheck(ancestor)) {
+                rebuild(linkSlot(path[i]));
+            }
+        }
+        return true;
+    }
+    
+    /**
+     * @brief 按坐标删除单个点 - 调用者已持有写锁，坐标已对齐到量化网格
+     */
+    void deletePoint(const PointType& point)
+    {
+        /**
+         * @brief 按坐标删除单个点实现 - 后台重建期间记录到重建日志
+         */
+        if (!isRebuildTarget(m_rootNode)) {
+            deleteByPoint(&m_rootNode, point, true);
+        } else {
+            Operation_Logger_Type operation;
+            operation.point = point;
+            operation.op = DELETE_POINT;
+            
+            QMutexLocker workingLocker(&m_workingFlagMutex);
+            deleteByPoint(&m_rootNode, point, false);
+            
+            if (m_rebuildFlag.loadAcquire()) {
+                QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
+                m_rebuildLogger.push(operation);
+            }
+        }
+    }
+    
+    /**
+     * @brief 插入点所在的分区 - 与addByPoint的下降方向一致
+     */
+    int routePoint(const PointType& point) const
+    {
+        qint32 code = regionRoot();
+        while (code >= 0) {
+            const UPPER_NODE& upper = m_regionUpper[code];
+            const KD_TREE_NODE* root = node(upper.index);
+            const int axis = root->division_axis;
+            const Scalar pointValue = axis == 0 ? point.x : (axis == 1 ? point.y : point.z);
+            const Scalar splitValue = axis == 0 ? root->point.x : (axis == 1 ? root->point.y : root->point.z);
+            code = upper.son[pointValue < splitValue ? 0 : 1];
+        }
+        return ~code;
+    }
+    
+    /**
+     * @brief 包围盒可能涉及的分区和上层节点 - 按分割面两侧闭区间判断，是各区域写操作实际访问范围的超集
+     * @param boxpoint 操作范围，点操作取退化包围盒
+     * @param upperHit 判断上层节点自身的点是否受操作影响
+     * @param touch 输出涉及的分区（升序）和是否涉及上层节点
+     */
+    template<typename UpperHit>
+    void routeBox(const BoxType& boxpoint, UpperHit upperHit, REGION_TOUCH& touch) const
+    {
+        touch.partitions.clear();
+        touch.upper = false;
+        QVarLengthArray<qint32, 2 * MAX_WRITER_PARTITION_DEPTH + 2> stack;
+        stack.append(regionRoot());
+        while (!stack.isEmpty()) {
+            const qint32 code = stack.takeLast();
+            if (code < 0) {
+                touch.partitions.append(~code);
+                continue;
+            }
+            const UPPER_NODE& upper = m_regionUpper[code];
+            const KD_TREE_NODE* root = node(upper.index);
+            if (upperHit(root->point)) touch.upper = true;
+            const int axis = root->division_axis;
+            const Scalar splitValue = axis == 0 ? root->point.x : (axis == 1 ? root->point.y : root->point.z);
+            if (boxpoint.vertex_max[axis] >= splitValue) stack.append(upper.son[1]);
+            if (boxpoint.vertex_min[axis] <= splitValue) stack.append(upper.son[0]);
+        }
+        std::sort(touch.partitions.begin(), touch.partitions.end());
+    }
+    
+    /**
+     * @brief 点是否在包围盒内 - 与按范围搜索、删除相同的左闭右开判断
+     */
+    static bool boxContains(const BoxType& boxpoint, const PointType& point)
+    {
+        return boxpoint.vertex_min[0] <= point.x && boxpoint.vertex_max[0] > point.x && 
+               boxpoint.vertex_min[1] <= point.y && boxpoint.vertex_max[1] > point.y && 
+               boxpoint.vertex_min[2] <= point.z && boxpoint.vertex_max[2] > point.z;
+    }
+    
+    /**
+     * @brief 向分区插入点 - 分区根正在后台重建时记录到重建日志
+     */
+    void partitionAddPoint(const WRITER_PARTITION& partition, const PointType& point)
+    {
+        if (!isRebuildTarget(*partition.slot)) {
+            addByPoint(partition.slot, point, true, partition.fatherAxis);
+            return;
+        }
+        Operation_Logger_Type operation;
+        operation.point = point;
+        operation.op = ADD_POINT;
+        
+        QMutexLocker workingLocker(&m_workingFlagMutex);
+        addByPoint(partition.slot, point, false, partition.fatherAxis);
+        if (m_rebuildFlag.loadAcquire()) {
+            QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
+            m_rebuildLogger.push(operation);
+        }
+    }
+    
+    /**
+     * @brief 按包围盒删除分区内的点 - 分区根正在后台重建时记录到重建日志
+     */
+    int partitionDeleteBox(const WRITER_PARTITION& partition, const BoxType& boxpoint, bool isDownsample)
+    {
+        if (!isRebuildTarget(*partition.slot)) {
+            return deleteByRange(partition.slot, boxpoint, true, isDownsample);
+        }
+        Operation_Logger_Type operation;
+        operation.boxpoint = boxpoint;
+        operation.op = isDownsample ? DOWNSAMPLE_DELETE : DELETE_BOX;
+        
+        QMutexLocker workingLocker(&m_workingFlagMutex);
+        int tmpCounter = deleteByRange(partition.slot, boxpoint, false, isDownsample);
+        if (m_rebuildFlag.loadAcquire()) {
+            QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
+            m_rebuildLogger.push(operation);
+        }
+        return tmpCounter;
+    }
+    
+    /**
+     * @brief 以整棵树为一个分区 - 串行修改和单分区区域写会话使用
+     */
+    WRITER_PARTITION wholeTreePartition()
+    {
+        const int rootAxis = m_rootNode != NULL_NODE ? node(m_rootNode)->division_axis : 0;
+        return WRITER_PARTITION{&m_rootNode, rootAxis};
+    }
+    
+    /**
+     * @brief 输入点对齐到压缩叶块量化网格后的坐标，未开启压缩叶块时不变
+     */
+    PointType gridPoint(const PointType& point) const
+    {
+        PointType snapped = point;
+        if (m_compressedLeafSize > 1) snapToGrid(snapped);
+        return snapped;
+    }
+    
+    /**
+     * @brief 点所在的下采样体素及体素中心
+     */
+    void downsampleBox(const PointType& point, BoxType& boxOfPoint, PointType& midPoint) const
+    {
+        boxOfPoint.vertex_min[0] = qFloor(point.x / m_downsampleSize) * m_downsampleSize;
+        boxOfPoint.vertex_max[0] = boxOfPoint.vertex_min[0] + m_downsampleSize;
+        boxOfPoint.vertex_min[1] = qFloor(point.y / m_downsampleSize) * m_downsampleSize;
+        boxOfPoint.vertex_max[1] = boxOfPoint.vertex_min[1] + m_downsampleSize;
+        boxOfPoint.vertex_min[2] = qFloor(point.z / m_downsampleSize) * m_downsampleSize;
+        boxOfPoint.vertex_max[2] = boxOfPoint.vertex_min[2] + m_downsampleSize;
+        
+        midPoint.x = boxOfPoint.vertex_min[0] + (boxOfPoint.vertex_max[0] - boxOfPoint.vertex_min[0]) / 2.0;
+        midPoint.y = boxOfPoint.vertex_min[1] + (boxOfPoint.vertex_max[1] - boxOfPoint.vertex_min[1]) / 2.0;
+        midPoint.z = boxOfPoint.vertex_min[2] + (boxOfPoint.vertex_max[2] - boxOfPoint.vertex_min[2]) / 2.0;
+    }
+    
+    /**
+     * @brief 下采样插入单个点 - 体素内只保留距体素中心最近的点
+     * @param searchBox 把体素内已有的点追加到downsampleStorage
+     * @param deleteBox 删除体素内已有的点
+     * @param addPoint 插入保留下来的点
+     * @return 是否插入了点
+     */
+    template<typename SearchBox, typename DeleteBox, typename AddPoint>
+    bool downsamplePoint(const PointType& point, PointVector& downsampleStorage, SearchBox searchBox,
+                         DeleteBox deleteBox, AddPoint addPoint)
+    {
+        BoxType boxOfPoint;
+        PointType midPoint;
+        downsampleBox(point, boxOfPoint, midPoint);
+        
+        downsampleStorage.clear();
+        searchBox(boxOfPoint);
+        double minDist = calcDist(point, midPoint);
+        PointType downsampleResult = point;
+        
+        for (int index = 0; index < downsampleStorage.size(); index++) {
+            double tmpDist = calcDist(downsampleStorage[index], midPoint);
+            if (tmpDist < minDist) {
+                minDist = tmpDist;
+                downsampleResult = downsampleStorage[index];
+            }
+        }
+        
+        if (downsampleStorage.size() > 1 || samePoint(point, downsampleResult)) {
+            if (downsampleStorage.size() > 0) {
+                deleteBox(boxOfPoint);
+            }
+            addPoint(downsampleResult);
+            return true;
+        }
+        return false;
+    }
+    
+    /**
+     * @brief 平铺树节点
+     */
+    void flatten(NodeIndex rootIdx, PointVector& storage, delete_point_storage_set storageType)
+    {
+        /**
+         * @brief 展平树结构实现 - 将子树所有点提取到向量中
+         * 
+         * 以显式栈代替递归，先序输出未删除点，需要记录已删除点时在后序阶段记录，顺序与递归版本相同
+         */
+        TraversalStack<VISIT_FRAME> stack;
+        stack.append(VISIT_FRAME{rootIdx, false, nullptr});
+        while (!stack.isEmpty()) {
+            const NodeIndex index = stack.last().index;
+            const bool post = stack.last().post;
+            stack.removeLast();
+            if (index == NULL_NODE) continue;
+            KD_TREE_NODE* root = node(index);
+            
+            if (post) {
+                switch (storageType) {
+                case DELETE_POINTS_REC:
+                    if (root->point_deleted && !root->point_downsample_deleted) {
+                        m_pointsDeleted.append(root->point);
+                    }
+                    break;
+                case MULTI_THREAD_REC:
+                    if (root->point_deleted && !root->point_downsample_deleted) {
+                        m_multithreadPointsDeleted.append(root->point);
+                    }
+                    break;
+                default:
+                    break;
+                }
+                continue;
+            }
+            
+            pushDown(root);
+            if (root->leaf_idx != 0) {
+                const LEAF_BLOCK& leaf = m_leafBlocks.at(root->leaf_idx);
+                for (int i = 0; i < leaf.count; i++) {
+                    if (!root->tree_deleted) {
+                        storage.append(leaf.decode(i));
+                    } else if (storageType == DELETE_POINTS_REC && !root->tree_downsample_deleted) {
+                        m_pointsDeleted.append(leaf.decode(i));
+                    } else if (storageType == MULTI_THREAD_REC && !root->tree_downsample_deleted) {
+                        m_multithreadPointsDeleted.append(leaf.decode(i));
+                    }
+                }
+                continue;
+            }
+            if (!root->point_deleted) {
+                storage.append(root->point);
+            }
+            
+            if (storageType != NOT_RECORD) stack.append(VISIT_FRAME{index, true, nullptr});
+            if (root->right_son_idx != NULL_NODE) stack.append(VISIT_FRAME{root->right_son_idx, false, nullptr});
+            if (root->left_son_idx != NULL_NODE) stack.append(VISIT_FRAME{root->left_son_idx, false, nullptr});
+        }
+    }
+    
+    /**
+     * @brief 只读平铺子树 - 输出与flatten(NOT_RECORD)相同的点和顺序，供查询路径使用
+     * @param budget 非空时每平铺SEARCH_DEADLINE_CHECK_INTERVAL个节点检查一次截止时刻
+     * @return 截止时刻已到、平铺提前停止时为false
+     */
+    bool collectPoints(NodeIndex rootIdx, quint8 rootInherited, PointVector& storage,
+                       const SEARCH_BUDGET* budget = nullptr) const
+    {
+        /**
+         * @brief 只读平铺实现 - 删除状态由继承位推导，不下推、不写节点
+         */
+        TraversalStack<QUERY_FRAME> stack;
+        stack.append(QUERY_FRAME{rootIdx, rootInherited});
+        int sinceCheck = 0;
+        while (!stack.isEmpty()) {
+            const NodeIndex index = stack.last().index;
+            const quint8 inherited = stack.last().inherited;
+            stack.removeLast();
+            if (index == NULL_NODE) continue;
+            if (budget != nullptr && ++sinceCheck == SEARCH_DEADLINE_CHECK_INTERVAL) {
+                sinceCheck = 0;
+                if (budget->deadline.hasExpired()) return false;
+            }
+            const KD_TREE_NODE* root = node(index);
+            const DELETE_VIEW view = deleteView(root, inherited);
+            
+            if (root->leaf_idx != 0) {
+                if (view.treeDeleted) continue;
+                const LEAF_BLOCK& leaf = m_leafBlocks.at(root->leaf_idx);
+                for (int i = 0; i < leaf.count; i++) {
+                    storage.append(leaf.decode(i));
+                }
+                continue;
+            }
+            if (!view.pointDeleted) {
+                storage.append(root->point);
+            }
+            
+            if (root->right_son_idx != NULL_NODE) stack.append(QUERY_FRAME{root->right_son_idx, view.rightInherited});
+            if (root->left_son_idx != NULL_NODE) stack.append(QUERY_FRAME{root->left_son_idx, view.leftInherited});
+        }
+        return true;
+    }
+    
+    void initTreeNode(KD_TREE_NODE* root) {
+        /**
+         * @brief 初始化树节点实现 - 设置节点默认值
+         */
+        if (!root) return;
+        
+        root->point = PointType(0.0, 0.0, 0.0);
+        root->node_range_x[0] = root->node_range_x[1] = 0.0;
+        root->node_range_y[0] = root->node_range_y[1] = 0.0;
+        root->node_range_z[0] = root->node_range_z[1] = 0.0;
+        root->division_axis = 0;
+        root->father_idx = NULL_NODE;
+        root->left_son_idx = NULL_NODE;
+        root->right_son_idx = NULL_NODE;
+        root->TreeSize = 0;
+        root->invalid_point_num = 0;
+        root->down_del_num = 0;
+        root->point_deleted = false;
+        root->tree_deleted = false;
+        root->need_push_down_to_left = false;
+        root->need_push_down_to_right = false;
+        root->point_downsample_deleted = false;
+        root->working_flag = false;
+        root->leaf_idx = 0;
+    }
+
+    void buildTree(NodeIndex* root, int l, int r, PointVector& storage, bool allowCompress = true, bool trackIds = true) {
+        /**
+         * @brief 构建K-D树实现 - 核心构建算法
+         * 
+         * 以显式栈代替递归：先序阶段选轴、划分并分配节点，后序阶段在左右子树完成后更新节点，
+         * 节点分配和更新顺序与递归版本相同；trackIds为false时不登记点编号
+         */
+        TraversalStack<BUILD_FRAME> stack;
+        stack.append(BUILD_FRAME{root, l, r, false});
+        while (!stack.isEmpty()) {
+            NodeIndex* slot = stack.last().slot;
+            const int lo = stack.last().l, hi = stack.last().r;
+            const bool post = stack.last().post;
+            stack.removeLast();
+            if (post) {
+                update(*slot);
+                continue;
+            }
+            if (lo > hi) continue;
+            
+            int mid = (lo + hi) >> 1;
+            int divAxis = 0;
+            
+            // 找到最佳分割轴
+            Scalar minValue[3] = {std::numeric_limits<Scalar>::infinity(), 
+                                 std::numeric_limits<Scalar>::infinity(), 
+                                 std::numeric_limits<Scalar>::infinity()};
+            Scalar maxValue[3] = {-std::numeric_limits<Scalar>::infinity(), 
+                                 -std::numeric_limits<Scalar>::infinity(), 
+                                 -std::numeric_limits<Scalar>::infinity()};
+            Scalar dimRange[3] = {0, 0, 0};
+            
+            for (int i = lo; i <= hi; i++) {
+                minValue[0] = qMin(minValue[0], storage[i].x);
+                minValue[1] = qMin(minValue[1], storage[i].y);
+                minValue[2] = qMin(minValue[2], storage[i].z);
+                maxValue[0] = qMax(maxValue[0], storage[i].x);
+                maxValue[1] = qMax(maxValue[1], storage[i].y);
+                maxValue[2] = qMax(maxValue[2], storage[i].z);
+            }
+            
+            // 选择最长维度作为分割轴
+            for (int i = 0; i < 3; i++) dimRange[i] = maxValue[i] - minValue[i];
+            for (int i = 1; i < 3; i++) if (dimRange[i] > dimRange[divAxis]) divAxis = i;
+            
+            // 点数和跨度都在量化范围内的子树整体存为压缩叶块，未开启压缩时按点数存为精确叶桶
+            if (allowCompress) {
+                bool compressed = m_compressedLeafSize > 1;
+                int blockSize = compressed ? m_compressedLeafSize : m_leafBucketSize;
+                if (blockSize > 1 && hi - lo + 1 <= blockSize &&
+                    (!compressed || dimRange[divAxis] < m_compressedResolution * 65534)) {
+                    buildLeafBlock(slot, lo, hi, storage, minValue);
+                    continue;
+                }
+            }
+            
+            *slot = m_nodePool.allocate();
+            KD_TREE_NODE* rootNode = node(*slot);
+            initTreeNode(rootNode);
+            rootNode->division_axis = divAxis;
+            
+            // 按分割轴划分，子树入栈（左子树后入先出）
+            switch (divAxis) {
+            case 0:
+                std::nth_element(storage.begin() + lo, storage.begin() + mid, storage.begin() + hi + 1, pointCmpX);
+                break;
+            case 1:
+                std::nth_element(storage.begin() + lo, storage.begin() + mid, storage.begin() + hi + 1, pointCmpY);
+                break;
+            case 2:
+                std::nth_element(storage.begin() + lo, storage.begin() + mid, storage.begin() + hi + 1, pointCmpZ);
+                break;
+            default:
+                std::nth_element(storage.begin() + lo, storage.begin() + mid, storage.begin() + hi + 1, pointCmpX);
+                break;
+            }
+            
+            rootNode->point = storage[mid];
+            if (trackIds) trackPointId(rootNode->point, *slot);
+            stack.append(BUILD_FRAME{slot, lo, hi, true});
+            stack.append(BUILD_FRAME{&rootNode->right_son_idx, mid + 1, hi, false});
+            stack.append(BUILD_FRAME{&rootNode->left_son_idx, lo, mid - 1, false});
+        }
+    }
+
+    void buildLeafBlock(NodeIndex* root, int l, int r, PointVector& storage, const Scalar minValue[3]) {
+        /**
+         * @brief 构建叶块实现 - 压缩叶块以对齐到量化网格的包围盒最小顶点为原点编码16位偏移，精确叶桶直接复制坐标
+         */
+        *root = m_nodePool.allocate();
+        KD_TREE_NODE* rootNode = node(*root);
+        initTreeNode(rootNode);
+        int count = r - l + 1;
+        
+        QMutexLocker locker(&m_leafBlockMutex);
+        quint32 leafIdx;
+        if (!m_freeLeafBlocks.isEmpty()) {
+            leafIdx = m_freeLeafBlocks.takeLast();
+        } else {
+            if (m_leafBlocks.isEmpty()) m_leafBlocks.resize(1);
+            leafIdx = m_leafBlocks.size();
+            m_leafBlocks.resize(leafIdx + 1);
+        }
+        LEAF_BLOCK& leaf = m_leafBlocks[leafIdx];
+        leaf.count = count;
+        leaf.payload.resize(count);
+        if (m_compressedLeafSize > 1) {
+            leaf.stride = count;
+            leaf.codes.resize(3 * count);
+            leaf.step = m_compressedResolution;
+            for (int a = 0; a < 3; a++) {
+                leaf.origin[a] = qRound64(minValue[a] / m_compressedResolution);
+            }
+        } else {
+            // 精确叶桶之后逐点追加到桶容量，一次预留避免追加时搬移
+            leaf.stride = qMax(count, m_leafBucketSize);
+            leaf.coords.resize(3 * leaf.stride);
+            leaf.payload.reserve(leaf.stride);
+            leaf.step = 0;
+        }
+        for (int i = 0; i < count; i++) {
+            const PointType& point = storage[l + i];
+            if (leaf.step != 0) {
+                leaf.codes[i] = quantizeCoord(leaf, 0, point.x);
+                leaf.codes[leaf.stride + i] = quantizeCoord(leaf, 1, point.y);
+                leaf.codes[2 * leaf.stride + i] = quantizeCoord(leaf, 2, point.z);
+            } else {
+                leaf.coords[i] = point.x;
+                leaf.coords[leaf.stride + i] = point.y;
+                leaf.coords[2 * leaf.stride + i] = point.z;
+            }
+            leaf.payload[i] = point.data;
+            trackPointId(point, *root);
+        }
+        
+        // 包围盒取解码后坐标的范围，保证剪枝与解码结果一致
+        Scalar* ranges[3] = {rootNode->node_range_x, rootNode->node_range_y, rootNode->node_range_z};
+        for (int a = 0; a < 3; a++) {
+            ranges[a][0] = std::numeric_limits<Scalar>::infinity();
+            ranges[a][1] = -std::numeric_limits<Scalar>::infinity();
+            for (int i = 0; i < count; i++) {
+                ranges[a][0] = qMin(ranges[a][0], leaf.coord(a, i));
+                ranges[a][1] = qMax(ranges[a][1], leaf.coord(a, i));
+            }
+        }
+        rootNode->point = leaf.decode(0);
+        rootNode->leaf_idx = leafIdx;
+        rootNode->TreeSize = count;
+    }
+
+    quint16 quantizeCoord(const LEAF_BLOCK& leaf, int axis, Scalar value) const {
+        /**
+         * @brief 量化单个坐标实现 - 返回最近网格点相对叶块原点的偏移
+         */
+        qint64 code = qRound64(value / leaf.step) - leaf.origin[axis];
+        return quint16(qBound<qint64>(0, code, 65535));
+    }
+
+    void snapToGrid(PointType& point) const {
+        /**
+         * @brief 坐标对齐到量化网格实现 - 与叶块解码使用相同的计算，结果逐位一致
+         */
+        point.x = Scalar(double(qRound64(point.x / m_compressedResolution)) * m_compressedResolution);
+        point.y = Scalar(double(qRound64(point.y / m_compressedResolution)) * m_compressedResolution);
+        point.z = Scalar(double(qRound64(point.z / m_compressedResolution)) * m_compressedResolution);
+    }
+
+    void releaseLeafBlock(quint32 leafIdx) {
+        /**
+         * @brief 释放叶块实现
+         */
+        QMutexLocker locker(&m_leafBlockMutex);
+        m_leafBlocks[leafIdx] = LEAF_BLOCK();
+        m_freeLeafBlocks.append(leafIdx);
+    }
+
+    KD_TREE_NODE* thawLeafBlock(NodeIndex* root) {
+        /**
+         * @brief 解冻叶块实现 - 解码为普通节点子树，删除标志留在新子树根上延迟下推
+         */
+        KD_TREE_NODE* leafNode = node(*root);
+        const LEAF_BLOCK& leaf = m_leafBlocks.at(leafNode->leaf_idx);
+        PointVector storage;
+        storage.reserve(leaf.count);
+        for (int i = 0; i < leaf.count; i++) {
+            storage.append(leaf.decode(i));
+        }
+        NodeIndex fatherIdx = leafNode->father_idx;
+        bool treeDeleted = leafNode->tree_deleted;
+        bool treeDownsampleDeleted = leafNode->tree_downsample_deleted;
+        releaseLeafBlock(leafNode->leaf_idx);
+        m_nodePool.release(*root);
+        
+        *root = NULL_NODE;
+        // 整块已删除的点不再登记编号，其编号可能已被KD_TREE_PAYLOAD分配给新点
+        buildTree(root, 0, storage.size() - 1, storage, false, !treeDeleted);
+        KD_TREE_NODE* rootNode = node(*root);
+        rootNode->father_idx = fatherIdx;
+        if (treeDeleted) {
+            rootNode->tree_deleted = true;
+            rootNode->point_deleted = true;
+            rootNode->tree_downsample_deleted = treeDownsampleDeleted;
+            rootNode->point_downsample_deleted = treeDownsampleDeleted;
+            rootNode->invalid_point_num = rootNode->TreeSize;
+            rootNode->down_del_num = treeDownsampleDeleted ? rootNode->TreeSize : 0;
+            rootNode->need_push_down_to_left = true;
+            rootNode->need_push_down_to_right = true;
+        }
+        if (root == &m_rootNode && m_staticRootNode != NULL_NODE) {
+            node(m_staticRootNode)->left_son_idx = m_rootNode;
+        }
+        return rootNode;
+    }
+
+    bool leafBlockContains(const KD_TREE_NODE* leafNode, const PointType& point) const {
+        /**
+         * @brief 判断叶块是否含有指定点实现 - 逐点比较解码坐标
+         */
+        const LEAF_BLOCK& leaf = m_leafBlocks.at(leafNode->leaf_idx);
+        for (int i = 0; i < leaf.count; i++) {
+            if (samePoint(leaf.decode(i), point)) return true;
+        }
+        return false;
+    }
+
+    bool appendToLeafBucket(KD_TREE_NODE* leafNode, const PointType& point) {
+        /**
+         * @brief 向精确叶桶追加点实现 - 叶块整体删除标志只能表示全部有效或全部删除，已删除的叶桶不能追加
+         */
+        QMutexLocker locker(&m_leafBlockMutex);
+        LEAF_BLOCK& leaf = m_leafBlocks[leafNode->leaf_idx];
+        if (leaf.step != 0 || leafNode->tree_deleted || leaf.count >= m_leafBucketSize) return false;
+        leaf.append(point);
+        leafNode->node_range_x[0] = qMin(leafNode->node_range_x[0], point.x);
+        leafNode->node_range_x[1] = qMax(leafNode->node_range_x[1], point.x);
+        leafNode->node_range_y[0] = qMin(leafNode->node_range_y[0], point.y);
+        leafNode->node_range_y[1] = qMax(leafNode->node_range_y[1], point.y);
+        leafNode->node_range_z[0] = qMin(leafNode->node_range_z[0], point.z);
+        leafNode->node_range_z[1] = qMax(leafNode->node_range_z[1], point.z);
+        leafNode->TreeSize = leaf.count;
+        return true;
+    }
+
+    bool leafBlockContainsId(const KD_TREE_NODE* leafNode, PointId id) const {
+        /**
+         * @brief 判断叶块是否含有指定编号实现
+         */
+        const LEAF_BLOCK& leaf = m_leafBlocks.at(leafNode->leaf_idx);
+        for (int i = 0; i < leaf.count; i++) {
+            if (PointId(leaf.payload[i]) == id) return true;
+        }
+        return false;
+    }
+
+    PointType leafBlockPointById(const KD_TREE_NODE* leafNode, PointId id) const {
+        /**
+         * @brief 按编号解码叶块中的点实现
+         */
+        const LEAF_BLOCK& leaf = m_leafBlocks.at(leafNode->leaf_idx);
+        for (int i = 0; i < leaf.count; i++) {
+            if (PointId(leaf.payload[i]) == id) return leaf.decode(i);
+        }
+        return PointType();
+    }
+
+    void trackPointId(const PointType& point, NodeIndex index) {
+        /**
+         * @brief 记录点编号所在节点实现 - 未开启编号映射时为空操作
+         */
+        if constexpr (std::is_integral_v<PayloadType>) {
+            if (!m_pointIdTracking) return;
+            int id = int(point.data);
+            if (id < 0) return;
+            if (id >= m_pointIdNodes.size()) {
+                if (id >= m_pointIdNodes.capacity()) m_pointIdNodes.reserve(qMax(id + 1, int(m_pointIdNodes.capacity()) * 2));
+                m_pointIdNodes.resize(id + 1);
+            }
+            m_pointIdNodes[id] = index;
+        } else {
+            Q_UNUSED(point);
+            Q_UNUSED(index);
+        }
+    }
+
+    void collectAncestors(NodeIndex index, QVarLengthArray<NodeIndex, 64>& path) const {
+        /**
+         * @brief 收集祖先节点实现 - 由近及远，不含静态根节点
+         */
+        path.clear();
+        for (NodeIndex ancestor = node(index)->father_idx; ancestor != NULL_NODE && ancestor != m_staticRootNode;
+             ancestor = node(ancestor)->father_idx) {
+            path.append(ancestor);
+        }
+    }
+
+    NodeIndex* linkSlot(NodeIndex index) {
+        /**
+         * @brief 获取指向节点的链接槽实现 - 根节点返回m_rootNode，其余返回父节点的子节点索引
+         */
+        if (index == m_rootNode) return &m_rootNode;
+        KD_TREE_NODE* father = node(node(index)->father_idx);
+        return father->left_son_idx == index ? &father->left_son_idx : &father->right_son_idx;
+    }
+
+    bool collectWithinBudget(const KD_TREE_NODE* root, int& visited, SEARCH_BUDGET* budget) const {
+        /**
+         * @brief 判断整棵落入范围的子树能否在剩余节点数内整体收集，能则计入其节点数
+         * 
+         * 整体收集前检查一次截止时刻，已过期时令下一次allows()立即检查，逐节点遍历随即停止；
+         * 收集过程中由collectPoints()按间隔检查截止时刻
+         */
+        if (budget == nullptr) return true;
+        if (root->TreeSize - 1 > budget->maxVisited - visited) return false;
+        if (budget->deadline.hasExpired()) {
+            budget->limit = visited;
+            return false;
+        }
+        visited += root->TreeSize - 1;
+        return true;
+    }
+
+    void searchByRange(NodeIndex rootIdx, const BoxType& boxpoint, PointVector& storage,
+                       quint8 rootInherited = INHERIT_NONE, SEARCH_BUDGET* budget = nullptr) const {
+        /**
+         * @brief 按范围搜索实现 - 以显式栈先序遍历，输出顺序与递归版本相同
+         * 
+         * 只读遍历：不下推删除标记，祖先未下推的删除状态随栈帧传给子树。
+         * 有节点预算时每个节点计一次，整棵落入范围的子树不超过剩余节点数时整体收集，否则逐个节点遍历
+         */
+        TraversalStack<QUERY_FRAME> stack;
+        stack.append(QUERY_FRAME{rootIdx, rootInherited});
+        int visited = 0;
+        while (!stack.isEmpty()) {
+            const NodeIndex index = stack.last().index;
+            const quint8 inherited = stack.last().inherited;
+            if (index != NULL_NODE && budget != nullptr && !budget->allows(visited)) {
+                budget->truncated = true;
+                return;
+            }
+            stack.removeLast();
+            prefetchPending(stack);
+            if (index == NULL_NODE) continue;
+            
+            const KD_TREE_NODE* root = node(index);
+            visited++;
+            
+            if (boxpoint.vertex_max[0] <= root->node_range_x[0] || boxpoint.vertex_min[0] > root->node_range_x[1]) continue;
+            if (boxpoint.vertex_max[1] <= root->node_range_y[0] || boxpoint.vertex_min[1] > root->node_range_y[1]) continue;
+            if (boxpoint.vertex_max[2] <= root->node_range_z[0] || boxpoint.vertex_min[2] > root->node_range_z[1]) continue;
+            
+            if (boxpoint.vertex_min[0] <= root->node_range_x[0] && boxpoint.vertex_max[0] > root->node_range_x[1] && 
+                boxpoint.vertex_min[1] <= root->node_range_y[0] && boxpoint.vertex_max[1] > root->node_range_y[1] && 
+                boxpoint.vertex_min[2] <= root->node_range_z[0] && boxpoint.vertex_max[2] > root->node_range_z[1] &&
+                collectWithinBudget(root, visited, budget)) {
+                if (!collectPoints(index, inherited, storage, budget)) {
+                    budget->truncated = true;
+                    return;
+                }
+                continue;
+            }
+            
+            const DELETE_VIEW view = deleteView(root, inherited);
+            if (root->leaf_idx != 0) {
+                if (view.treeDeleted) continue;
+                const LEAF_BLOCK& leaf = m_leafBlocks.at(root->leaf_idx);
+                for (int i = 0; i < leaf.count; i++) {
+                    Scalar x = leaf.coord(0, i), y = leaf.coord(1, i), z = leaf.coord(2, i);
+                    if (boxpoint.vertex_min[0] <= x && boxpoint.vertex_max[0] > x && 
+                        boxpoint.vertex_min[1] <= y && boxpoint.vertex_max[1] > y && 
+                        boxpoint.vertex_min[2] <= z && boxpoint.vertex_max[2] > z) {
+                        storage.append(leaf.decode(i));
+                    }
+                }
+                continue;
+            }
+            
+            prefetchNode(root->left_son_idx);
+            prefetchNode(root->right_son_idx);
+            
+            if (boxpoint.vertex_min[0] <= root->point.x && boxpoint.vertex_max[0] > root->point.x && 
+                boxpoint.vertex_min[1] <= root->point.y && boxpoint.vertex_max[1] > root->point.y && 
+                boxpoint.vertex_min[2] <= root->point.z && boxpoint.vertex_max[2] > root->point.z) {
+                if (!view.pointDeleted) storage.append(root->point);
+            }
+            
+            stack.append(QUERY_FRAME{root->right_son_idx, view.rightInherited});
+            stack.append(QUERY_FRAME{root->left_son_idx, view.leftInherited});
+        }
+    }
+
+    void searchByRadius(NodeIndex rootIdx, const PointType& point, double radius, PointVector& storage,
+                        quint8 rootInherited = INHERIT_NONE, SEARCH_BUDGET* budget = nullptr) const {
+        /**
+         * @brief 按半径搜索实现 - 以显式栈先序遍历，输出顺序与递归版本相同；只读遍历和节点预算与searchByRange相同
+         */
+        TraversalStack<QUERY_FRAME> stack;
+        stack.append(QUERY_FRAME{rootIdx, rootInherited});
+        int visited = 0;
+        while (!stack.isEmpty()) {
+            const NodeIndex index = stack.last().index;
+            const quint8 inherited = stack.last().inherited;
+            if (index != NULL_NODE && budget != nullptr && !budget->allows(visited)) {
+                budget->truncated = true;
+                return;
+            }
+            stack.removeLast();
+            prefetchPending(stack);
+            if (index == NULL_NODE) continue;
+            
+            const KD_TREE_NODE* root = node(index);
+            visited++;
+            PointType rangeCenter;
+            rangeCenter.x = (root->node_range_x[0] + root->node_range_x[1]) * 0.5;
+            rangeCenter.y = (root->node_range_y[0] + root->node_range_y[1]) * 0.5;
+            rangeCenter.z = (root->node_range_z[0] + root->node_range_z[1]) * 0.5;
+            
+            double dist = qSqrt(calcDist(rangeCenter, point));
+            double nodeRadius = qSqrt(nodeRadiusSq(root));
+            if (dist > radius + nodeRadius) continue;
+            
+            if (dist <= radius - nodeRadius && collectWithinBudget(root, visited, budget)) {
+                if (!collectPoints(index, inherited, storage, budget)) {
+                    budget->truncated = true;
+                    return;
+                }
+                continue;
+            }
+            
+            const DELETE_VIEW view = deleteView(root, inherited);
+            if (root->leaf_idx != 0) {
+                if (view.treeDeleted) continue;
+                const LEAF_BLOCK& leaf = m_leafBlocks.at(root->leaf_idx);
+                QVarLengthArray<Scalar, 64> dist(leaf.count);
+                leaf.distances(point, dist.data());
+                for (int i = 0; i < leaf.count; i++) {
+                    if (dist[i] <= radius * radius) storage.append(leaf.decode(i));
+                }
+                continue;
+            }
+            
+            prefetchNode(root->left_son_idx);
+            prefetchNode(root->right_son_idx);
+            
+            if (!view.pointDeleted && calcDist(root->point, point) <= radius * radius) {
+                storage.append(root->point);
+            }
+            
+            stack.append(QUERY_FRAME{root->right_son_idx, view.rightInherited});
+            stack.append(QUERY_FRAME{root->left_son_idx, view.leftInherited});
+        }
+    }
+
+    void searchNearest(const PointType& point, int kNearest, PointVector& nearestPoints,
+                       QVector<double>& pointDistance, double maxDist, int* visitedNodes,
+                       Scalar pruneScale, SEARCH_BUDGET& budget) const {
+        /**
+         * @brief 单个K近邻查询实现 - 调用者已持有读锁，堆和遍历栈均为本次调用的局部状态
+         */
+        MANUAL_HEAP q(2 * kNearest);
+        q.clear();
+        pointDistance.clear();
+        int visited = 0;
+        auto searchRoot = [&]() {
+            if (m_splitPlanePruning) {
+                Scalar offset[3] = {0, 0, 0};
+                searchSplitPlane(m_rootNode, kNearest, point, q, maxDist * maxDist, pruneScale, budget, offset, visited);
+            } else {
+                search(m_rootNode, kNearest, point, q, maxDist * maxDist, pruneScale, budget, visited);
+            }
+        };
+        
+        searchRoot();
+        if (visitedNodes != nullptr) *visitedNodes = visited;
+        takeNearest(q, kNearest, nearestPoints, pointDistance);
+    }
+
+    void takeNearest(MANUAL_HEAP& q, int kNearest, PointVector& nearestPoints, QVector<double>& pointDistance) const {
+        /**
+         * @brief 取出K近邻结果实现 - 按距离升序输出堆中的点并清空堆
+         */
+        int kFound = qMin(kNearest, q.size());
+        nearestPoints.clear();
+        pointDistance.clear();
+        
+        for (int i = 0; i < kFound; i++) {
+            nearestPoints.prepend(q.top().point);
+            pointDistance.prepend(q.top().dist);
+            q.pop();
+        }
+    }
+
+    template<typename Frame>
+    void searchBatch(const PointVector& queries, int kNearest, QVector<PointVector>& nearestPoints,
+                     QVector<QVector<double>>& pointDistances, double maxDistSqr,
+                     const APPROXIMATE_SEARCH& approximate) const {
+        /**
+         * @brief 交错批量K近邻搜索实现 - 以手写状态机轮转推进一组查询
+         * 
+         * 每轮每个查询只进入一个节点并预取其子节点，或从栈中取出下一个未被剪枝的子树并预取其根节点，随后切换到下一个查询。
+         * 包围盒剪枝需读取子节点包围盒才能决定下降顺序，因此上一轮进入的节点在本轮开头展开，此时子节点已预取一整轮。
+         * 查询完成后槽位立即换入下一个查询，节点数上限按查询分别计数
+         */
+        constexpr bool splitPlane = std::is_same<Frame, SPLIT_FRAME>::value;
+        const Scalar always = -std::numeric_limits<Scalar>::infinity();
+        const Scalar pruneScale = Scalar(approximate.pruneScale());
+        const int maxVisited = approximate.visitBudget();
+        BATCH_QUERY<Frame> group[BATCH_SEARCH_GROUP];
+        int nextQuery = 0;
+        int active = 0;
+        
+        auto start = [&](BATCH_QUERY<Frame>& slot) {
+            slot.query = nextQuery < queries.size() ? nextQuery++ : -1;
+            if (slot.query < 0) return;
+            slot.q.clear();
+            slot.stack.clear();
+            slot.index = NULL_NODE;
+            slot.visited = 0;
+            if constexpr (splitPlane) {
+                slot.stack.append(SPLIT_FRAME{m_rootNode, INHERIT_NONE, always, {0, 0, 0}});
+            } else {
+                slot.stack.append(SEARCH_FRAME{m_rootNode, INHERIT_NONE, always});
+            }
+            active++;
+        };
+        auto popNext = [&](BATCH_QUERY<Frame>& slot) {
+            while (!slot.stack.isEmpty() && slot.visited < maxVisited) {
+                const Frame& top = slot.stack.last();
+                const NodeIndex index = top.index;
+                const quint8 inherited = top.inherited;
+                const Scalar bound = top.bound;
+                if constexpr (splitPlane) {
+                    slot.cell[0] = top.offset[0];
+                    slot.cell[1] = top.offset[1];
+                    slot.cell[2] = top.offset[2];
+                }
+                slot.stack.removeLast();
+                if (slot.q.size() >= kNearest && !(bound * pruneScale < slot.q.top().dist)) continue;
+                slot.index = index;
+                slot.inherited = inherited;
+                return true;
+            }
+            return false;
+        };
+        
+        for (BATCH_QUERY<Frame>& slot : group) {
+            slot.q = MANUAL_HEAP(2 * kNearest);
+            start(slot);
+        }
+        while (active > 0) {
+            for (BATCH_QUERY<Frame>& slot : group) {
+                if (slot.query < 0) continue;
+                const PointType& point = queries[slot.query];
+                if constexpr (!splitPlane) {
+                    if (slot.expand) {
+                        slot.index = searchExpand(slot.index, slot.inherited, kNearest, point, slot.q, pruneScale,
+                                                  slot.stack);
+                        slot.expand = false;
+                    }
+                }
+                if (slot.index != NULL_NODE && slot.visited < maxVisited) {
+                    if constexpr (splitPlane) {
+                        slot.index = searchSplitPlaneStep(slot.index, slot.inherited, slot.cell, kNearest, point, slot.q,
+                                                          maxDistSqr, pruneScale, slot.stack, slot.visited);
+                    } else {
+                        slot.expand = searchEnter(slot.index, slot.inherited, kNearest, point, slot.q, maxDistSqr,
+                                                  slot.visited);
+                        if (!slot.expand) slot.index = NULL_NODE;
+                    }
+                    continue;
+                }
+                if (popNext(slot)) {
+                    prefetchNode(slot.index);
+                    continue;
+                }
+                takeNearest(slot.q, kNearest, nearestPoints[slot.query], pointDistances[slot.query]);
+                active--;
+                start(slot);
+            }
+        }
+    }
+
+    void search(NodeIndex rootIdx, int kNearest, const PointType& point, MANUAL_HEAP& q, double maxDistSqr,
+                Scalar pruneScale, SEARCH_BUDGET& budget, int& visited, quint8 rootInherited = INHERIT_NONE) const {
+        /**
+         * @brief K近邻搜索核心算法实现 - 按子节点包围盒决定下降顺序和剪枝
+         * 
+         * 以显式栈代替递归：必定访问的近侧子节点直接在内层循环中下降，其余子节点带上包围盒距离入栈，
+         * 出栈时按当时的堆顶重新判断，访问顺序和剪枝与递归版本相同。遍历只读，删除状态随栈帧继承。
+         * 下界乘以pruneScale后与堆顶比较，节点预算用尽即停止并记录是否截断
+         */
+        const Scalar always = -std::numeric_limits<Scalar>::infinity();
+        TraversalStack<SEARCH_FRAME> stack;
+        stack.append(SEARCH_FRAME{rootIdx, rootInherited, always});
+        while (!stack.isEmpty() && budget.allows(visited)) {
+            NodeIndex index = stack.last().index;
+            quint8 inherited = stack.last().inherited;
+            const Scalar bound = stack.last().bound;
+            stack.removeLast();
+            prefetchPending(stack);
+            if (q.size() >= kNearest && !(bound * pruneScale < q.top().dist)) continue;
+            
+            while (index != NULL_NODE && budget.allows(visited)) {
+                index = searchEnter(index, inherited, kNearest, point, q, maxDistSqr, visited)
+                      ? searchExpand(index, inherited, kNearest, point, q, pruneScale, stack) : NULL_NODE;
+            }
+            if (index != NULL_NODE) {
+                budget.truncated = true;
+                return;
+            }
+        }
+        budget.truncated = searchPending(stack, kNearest, q, pruneScale);
+    }
+
+    bool countLimitedSearch(const SEARCH_BUDGET& budget) const {
+        /**
+         * @brief 记录一次带时限的查询，返回是否被截断
+         */
+        m_limitedSearches.fetchAndAddRelaxed(1);
+        if (budget.truncated) m_truncatedSearches.fetchAndAddRelaxed(1);
+        return budget.truncated;
+    }
+
+    template<typename Frame>
+    bool searchPending(const TraversalStack<Frame>& stack, int kNearest, const MANUAL_HEAP& q, Scalar pruneScale) const {
+        /**
+         * @brief 判断提前停止的K近邻搜索是否还有未剪枝的子树
+         */
+        for (const Frame& frame : stack) {
+            if (q.size() < kNearest || frame.bound * pruneScale < q.top().dist) return true;
+        }
+        return false;
+    }
+
+    bool searchEnter(NodeIndex index, quint8 inherited, int kNearest, const PointType& point, MANUAL_HEAP& q,
+                     double maxDistSqr, int& visited) const {
+        /**
+         * @brief K近邻搜索进入节点实现 - 剪枝检查、处理节点自身的点并预取两个子节点，返回是否需要展开子节点
+         * 
+         * 逐个查询和交错批量查询共用searchEnter/searchExpand，访问顺序因此完全一致；
+         * 批量查询在两步之间切换到其他查询，展开时子节点的包围盒已经读入
+         */
+        const KD_TREE_NODE* root = node(index);
+        visited++;
+        const DELETE_VIEW view = deleteView(root, inherited);
+        if (view.treeDeleted) return false;
+        
+        double curDist = calcBoxDist(root, point);
+        if (curDist > maxDistSqr) return false;
+        
+        if (root->leaf_idx != 0) {
+            searchLeafBlock(root, kNearest, point, q, maxDistSqr);
+            return false;
+        }
+        
+        // 两个子节点的包围盒稍后即被读取，先发起访存，与点距离计算重叠
+        prefetchNode(root->left_son_idx);
+        prefetchNode(root->right_son_idx);
+        
+        if (!view.pointDeleted) {
+            double dist = calcDist(point, root->point);
+            if (dist <= maxDistSqr && (q.size() < kNearest || dist < q.top().dist)) {
+                if (q.size() >= kNearest) q.pop();
+                PointType_CMP currentPoint{root->point, dist};
+                q.push(currentPoint);
+            }
+        }
+        return true;
+    }
+
+    NodeIndex searchExpand(NodeIndex index, quint8& inherited, int kNearest, const PointType& point, const MANUAL_HEAP& q,
+                           Scalar pruneScale, TraversalStack<SEARCH_FRAME>& stack) const {
+        /**
+         * @brief K近邻搜索展开节点实现 - 按子节点包围盒距离排序，延后访问的子节点入栈，返回紧接着要进入的子节点
+         * 
+         * inherited传入index继承的删除状态位，返回时改为所返回子节点的继承位；返回NULL_NODE表示应从栈中取下一个子树
+         */
+        const KD_TREE_NODE* root = node(index);
+        const DELETE_VIEW view = deleteView(root, inherited);
+        Scalar distLeftNode, distRightNode;
+        calcSonBoxDist(root, point, distLeftNode, distRightNode);
+        
+        if (q.size() < kNearest || distLeftNode * pruneScale < q.top().dist && distRightNode * pruneScale < q.top().dist) {
+            // 近侧子节点必然访问，远侧子节点待近侧完成后再判断
+            if (distLeftNode <= distRightNode) {
+                if (root->right_son_idx != NULL_NODE) {
+                    stack.append(SEARCH_FRAME{root->right_son_idx, view.rightInherited, distRightNode});
+                }
+                inherited = view.leftInherited;
+                return root->left_son_idx;
+            }
+            if (root->left_son_idx != NULL_NODE) {
+                stack.append(SEARCH_FRAME{root->left_son_idx, view.leftInherited, distLeftNode});
+            }
+            inherited = view.rightInherited;
+            return root->right_son_idx;
+        }
+        if (root->right_son_idx != NULL_NODE) stack.append(SEARCH_FRAME{root->right_son_idx, view.rightInherited, distRightNode});
+        if (root->left_son_idx != NULL_NODE) stack.append(SEARCH_FRAME{root->left_son_idx, view.leftInherited, distLeftNode});
+        return NULL_NODE;
+    }
+
+    void searchLeafBlock(const KD_TREE_NODE* root, int kNearest, const PointType& point, MANUAL_HEAP& q, double maxDistSqr) const {
+        /**
+         * @brief 叶块K近邻搜索实现 - 先批量计算距离，仅在入堆时解码完整点
+         */
+        const LEAF_BLOCK& leaf = m_leafBlocks.at(root->leaf_idx);
+        QVarLengthArray<Scalar, 64> dist(leaf.count);
+        leaf.distances(point, dist.data());
+        for (int i = 0; i < leaf.count; i++) {
+            if (dist[i] <= maxDistSqr && (q.size() < kNearest || dist[i] < q.top().dist)) {
+                if (q.size() >= kNearest) q.pop();
+                q.push(PointType_CMP{leaf.decode(i), dist[i]});
+            }
+        }
+    }
+
+    void searchSplitPlane(NodeIndex rootIdx, int kNearest, const PointType& point, MANUAL_HEAP& q, double maxDistSqr,
+                          Scalar pruneScale, SEARCH_BUDGET& budget, const Scalar offset[3], int& visited,
+                          quint8 rootInherited = INHERIT_NONE) const {
+        /**
+         * @brief 按分割面剪枝的K近邻搜索实现
+         * 
+         * offset为查询点到当前单元在各轴上的偏移（单元内为0）。左子树各点在分割轴上不大于分割值、右子树不小于分割值，
+         * 因此远侧子树中任意点的距离不小于把该轴偏移换成到分割面距离后的偏移平方和，可在读取远侧子节点之前剪枝。
+         * 偏移平方和按x、y、z顺序重新求和，与calcDist舍入一致，不会误剪与边界等距的点。
+         * 近侧子节点沿用当前偏移直接下降，远侧子节点连同其单元偏移入栈，待近侧完成后按当时的堆顶判断
+         */
+        const Scalar always = -std::numeric_limits<Scalar>::infinity();
+        TraversalStack<SPLIT_FRAME> stack;
+        stack.append(SPLIT_FRAME{rootIdx, rootInherited, always, {offset[0], offset[1], offset[2]}});
+        while (!stack.isEmpty() && budget.allows(visited)) {
+            const SPLIT_FRAME& top = stack.last();
+            NodeIndex index = top.index;
+            quint8 inherited = top.inherited;
+            const Scalar bound = top.bound;
+            const Scalar cell[3] = {top.offset[0], top.offset[1], top.offset[2]};
+            stack.removeLast();
+            prefetchPending(stack);
+            if (q.size() >= kNearest && !(bound * pruneScale < q.top().dist)) continue;
+            
+            while (index != NULL_NODE && budget.allows(visited)) {
+                index = searchSplitPlaneStep(index, inherited, cell, kNearest, point, q, maxDistSqr, pruneScale, stack,
+                                             visited);
+            }
+            if (index != NULL_NODE) {
+                budget.truncated = true;
+                return;
+            }
+        }
+        budget.truncated = searchPending(stack, kNearest, q, pruneScale);
+    }
+
+    NodeIndex searchSplitPlaneStep(NodeIndex index, quint8& inherited, const Scalar cell[3], int kNearest,
+                                   const PointType& point, MANUAL_HEAP& q, double maxDistSqr, Scalar pruneScale,
+                                   TraversalStack<SPLIT_FRAME>& stack, int& visited) const {
+        /**
+         * @brief 分割面剪枝K近邻搜索单步实现 - 进入一个节点，返回沿用同一单元偏移的近侧子节点，inherited随之改为其继承位
+         */
+        const KD_TREE_NODE* root = node(index);
+        visited++;
+        const DELETE_VIEW view = deleteView(root, inherited);
+        if (view.treeDeleted) return NULL_NODE;
+        
+        // 节点内存已读入，再用自身紧包围盒剪枝
+        double curDist = calcBoxDist(root, point);
+        if (curDist > maxDistSqr || (q.size() >= kNearest && curDist * pruneScale >= q.top().dist)) return NULL_NODE;
+        
+        if (root->leaf_idx != 0) {
+            searchLeafBlock(root, kNearest, point, q, maxDistSqr);
+            return NULL_NODE;
+        }
+        
+        // 访问顺序只取决于分割值，先确定近侧和远侧并发起预取，再做点距离计算
+        const int axis = root->division_axis;
+        const Scalar pointValue = axis == 0 ? point.x : (axis == 1 ? point.y : point.z);
+        const Scalar splitValue = axis == 0 ? root->point.x : (axis == 1 ? root->point.y : root->point.z);
+        const Scalar diff = pointValue - splitValue;
+        const NodeIndex nearIdx = diff < 0 ? root->left_son_idx : root->right_son_idx;
+        const NodeIndex farIdx = diff < 0 ? root->right_son_idx : root->left_son_idx;
+        prefetchNode(nearIdx);
+        
+        SPLIT_FRAME far{farIdx, diff < 0 ? view.rightInherited : view.leftInherited, 0, {cell[0], cell[1], cell[2]}};
+        far.offset[axis] = diff;
+        far.bound = far.offset[0] * far.offset[0] + far.offset[1] * far.offset[1] + far.offset[2] * far.offset[2];
+        const bool farPending = farIdx != NULL_NODE && far.bound <= maxDistSqr;
+        if (farPending) prefetchNode(farIdx);
+        
+        if (!view.pointDeleted) {
+            double dist = calcDist(point, root->point);
+            if (dist <= maxDistSqr && (q.size() < kNearest || dist < q.top().dist)) {
+                if (q.size() >= kNearest) q.pop();
+                q.push(PointType_CMP{root->point, dist});
+            }
+        }
+        
+        if (farPending) stack.append(far);
+        inherited = diff < 0 ? view.leftInherited : view.rightInherited;
+        return nearIdx;
+    }
+
+    void addByPoint(NodeIndex* root, const PointType& point, bool allowRebuild, int fatherAxis) {
+        /**
+         * @brief 按点添加实现 - 添加单个点到树中
+         */
+        if (*root == NULL_NODE) {
+            *root = m_nodePool.allocate();
+            KD_TREE_NODE* newNode = node(*root);
+            initTreeNode(newNode);
+            newNode->point = point;
+            newNode->division_axis = (fatherAxis + 1) % 3;
+            trackPointId(point, *root);
+            update(*root);
+            return;
+        }
+        
+        KD_TREE_NODE* rootNode = node(*root);
+        if (rootNode->leaf_idx != 0) {
+            // 未删除且未满的精确叶桶直接追加，其余叶块先解冻
+            if (appendToLeafBucket(rootNode, point)) {
+                trackPointId(point, *root);
+                return;
+            }
+            rootNode = thawLeafBlock(root);
+        }
+        rootNode->working_flag = true;
+        Operation_Logger_Type addLog;
+        addLog.op = ADD_POINT;
+        addLog.point = point;
+        pushDown(rootNode);
+        
+        // 根据分割轴决定添加方向
+        bool goLeft = false;
+        if (rootNode->division_axis == 0) {
+            goLeft = (point.x < rootNode->point.x);
+        } else if (rootNode->division_axis == 1) {
+            goLeft = (point.y < rootNode->point.y);
+        } else {
+            goLeft = (point.z < rootNode->point.z);
+        }
+        
+        if (goLeft) {
+            if (!isRebuildTarget(rootNode->left_son_idx)) {
+                addByPoint(&rootNode->left_son_idx, point, allowRebuild, rootNode->division_axis);
+            } else {
+                QMutexLocker workingLocker(&m_workingFlagMutex);
+                addByPoint(&rootNode->left_son_idx, point, false, rootNode->division_axis);
+                if (m_rebuildFlag.loadAcquire()) {
+                    QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
+                    m_rebuildLogger.push(addLog);
+                }
+            }
+        } else {
+            if (!isRebuildTarget(rootNode->right_son_idx)) {
+                addByPoint(&rootNode->right_son_idx, point, allowRebuild, rootNode->division_axis);
+            } else {
+                QMutexLocker workingLocker(&m_workingFlagMutex);
+                addByPoint(&rootNode->right_son_idx, point, false, rootNode->division_axis);
+                if (m_rebuildFlag.loadAcquire()) {
+                    QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
+                    m_rebuildLogger.push(addLog);
+                }
+            }
+        }
+        
+        update(*root);
+        
+        if (isRebuildTarget(*root) && 
+            rootNode->TreeSize < MULTI_THREAD_REBUILD_POINT_NUM) {
+            cancelBackgroundRebuild(*root);
+        }
+        
+        bool needRebuild = allowRebuild && criterionCheck(rootNode);
+        if (needRebuild) {
+            rebuild(root);
+        }
+        
+        rootNode = node(*root);
+        if (rootNode != nullptr) {
+            rootNode->working_flag = false;
+        }
+    }
+
+    bool deleteByPoint(NodeIndex* root, const PointType& point, bool allowRebuild) {
+        /**
+         * @brief 按点删除实现 - 删除指定点，返回是否找到
+         */
+        KD_TREE_NODE* rootNode = node(*root);
+        if (rootNode == nullptr || rootNode->tree_deleted) return false;
+        
+        if (rootNode->leaf_idx != 0) {
+            // 仅在叶块确实含有该点时解冻
+            if (!leafBlockContains(rootNode, point)) return false;
+            rootNode = thawLeafBlock(root);
+        }
+        
+        rootNode->working_flag = true;
+        pushDown(rootNode);
+        
+        if (samePoint(rootNode->point, point) && !rootNode->point_deleted) {
+            rootNode->point_deleted = true;
+            rootNode->invalid_point_num += 1;
+            if (rootNode->invalid_point_num == rootNode->TreeSize) {
+                rootNode->tree_deleted = true;
+            }
+            return true;
+        }
+        
+        Operation_Logger_Type deleteLog;
+        deleteLog.op = DELETE_POINT;
+        deleteLog.point = point;
+        
+        auto deleteFromSon = [&](NodeIndex* son) {
+            if (!isRebuildTarget(*son)) {
+                return deleteByPoint(son, point, allowRebuild);
+            }
+            QMutexLocker workingLocker(&m_workingFlagMutex);
+            bool found = deleteByPoint(son, point, false);
+            if (m_rebuildFlag.loadAcquire()) {
+                QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
+                m_rebuildLogger.push(deleteLog);
+            }
+            return found;
+        };
+        
+        // 根据分割轴决定搜索方向；与分割值相等的点构建时可能落在任一侧，先右后左
+        Scalar pointValue = rootNode->division_axis == 0 ? point.x : (rootNode->division_axis == 1 ? point.y : point.z);
+        Scalar splitValue = rootNode->division_axis == 0 ? rootNode->point.x
+                          : (rootNode->division_axis == 1 ? rootNode->point.y : rootNode->point.z);
+        bool found = false;
+        if (pointValue < splitValue) {
+            found = deleteFromSon(&rootNode->left_son_idx);
+        } else {
+            found = deleteFromSon(&rootNode->right_son_idx);
+            if (!found && pointValue == splitValue) {
+                found = deleteFromSon(&rootNode->left_son_idx);
+            }
+        }
+        
+        update(*root);
+        
+        if (isRebuildTarget(*root) && 
+            rootNode->TreeSize < MULTI_THREAD_REBUILD_POINT_NUM) {
+            cancelBackgroundRebuild(*root);
+        }
+        
+        bool needRebuild = allowRebuild && criterionCheck(rootNode);
+        if (needRebuild) {
+            rebuild(root);
+        }
+        
+        rootNode = node(*root);
+        if (rootNode != nullptr) {
+            rootNode->working_flag = false;
+        }
+        return found;
+    }
+
+    int deleteByRange(NodeIndex* root, const BoxType& boxpoint, bool allowRebuild, bool isDownsample) {
+        /**
+         * @brief 按包围盒删除实现 - 删除指定范围内的点
+         */
+        KD_TREE_NODE* rootNode = node(*root);
+        if (rootNode == nullptr || rootNode->tree_deleted) return 0;
+        
+        rootNode->working_flag = true;
+        pushDown(rootNode);
+        
+        int tmpCounter = 0;
+        
+        // 检查包围盒是否与节点范围相交
+        if (boxpoint.vertex_max[0] <= rootNode->node_range_x[0] || boxpoint.vertex_min[0] > rootNode->node_range_x[1]) return 0;
+        if (boxpoint.vertex_max[1] <= rootNode->node_range_y[0] || boxpoint.vertex_min[1] > rootNode->node_range_y[1]) return 0;
+        if (boxpoint.vertex_max[2] <= rootNode->node_range_z[0] || boxpoint.vertex_min[2] > rootNode->node_range_z[1]) return 0;
+        
+        // 如果包围盒完全包含节点范围，删除整个子树
+        if (boxpoint.vertex_min[0] <= rootNode->node_range_x[0] && boxpoint.vertex_max[0] > rootNode->node_range_x[1] && 
+            boxpoint.vertex_min[1] <= rootNode->node_range_y[0] && boxpoint.vertex_max[1] > rootNode->node_range_y[1] && 
+            boxpoint.vertex_min[2] <= rootNode->node_range_z[0] && boxpoint.vertex_max[2] > rootNode->node_range_z[1]) {
+            
+            rootNode->tree_deleted = true;
+            rootNode->point_deleted = true;
+            rootNode->need_push_down_to_left = true;
+            rootNode->need_push_down_to_right = true;
+            tmpCounter = rootNode->TreeSize - rootNode->invalid_point_num;
+            rootNode->invalid_point_num = rootNode->TreeSize;
+            
+            if (isDownsample) {
+                rootNode->tree_downsample_deleted = true;
+                rootNode->point_downsample_deleted = true;
+                rootNode->down_del_num = rootNode->TreeSize;
+            }
+            return tmpCounter;
+        }
+        
+        // 部分相交的叶块先解冻，再逐点处理
+        if (rootNode->leaf_idx != 0) {
+            rootNode = thawLeafBlock(root);
+            rootNode->working_flag = true;
+            pushDown(rootNode);
+        }
+        
+        // 检查当前节点的点是否在包围盒内
+        if (!rootNode->point_deleted && 
+            boxpoint.vertex_min[0] <= rootNode->point.x && boxpoint.vertex_max[0] > rootNode->point.x && 
+            boxpoint.vertex_min[1] <= rootNode->point.y && boxpoint.vertex_max[1] > rootNode->point.y && 
+            boxpoint.vertex_min[2] <= rootNode->point.z && boxpoint.vertex_max[2] > rootNode->point.z) {
+            
+            rootNode->point_deleted = true;
+            tmpCounter += 1;
+            if (isDownsample) rootNode->point_downsample_deleted = true;
+        }
+        
+        Operation_Logger_Type deleteBoxLog;
+        if (isDownsample) {
+            deleteBoxLog.op = DOWNSAMPLE_DELETE;
+        } else {
+            deleteBoxLog.op = DELETE_BOX;
+        }
+        deleteBoxLog.boxpoint = boxpoint;
+        
+        // 递归处理左子树
+        if (!isRebuildTarget(rootNode->left_son_idx)) {
+            tmpCounter += deleteByRange(&(rootNode->left_son_idx), boxpoint, allowRebuild, isDownsample);
+        } else {
+            QMutexLocker workingLocker(&m_workingFlagMutex);
+            tmpCounter += deleteByRange(&(rootNode->left_son_idx), boxpoint, false, isDownsample);
+            if (m_rebuildFlag.loadAcquire()) {
+                QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
+                m_rebuildLogger.push(deleteBoxLog);
+            }
+        }
+        
+        // 递归处理右子树
+        if (!isRebuildTarget(rootNode->right_son_idx)) {
+            tmpCounter += deleteByRange(&(rootNode->right_son_idx), boxpoint, allowRebuild, isDownsample);
+        } else {
+            QMutexLocker workingLocker(&m_workingFlagMutex);
+            tmpCounter += deleteByRange(&(rootNode->right_son_idx), boxpoint, false, isDownsample);
+            if (m_rebuildFlag.loadAcquire()) {
+                QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
+                m_rebuildLogger.push(deleteBoxLog);
+            }
+        }
+        
+        update(*root);
+        
+        if (isRebuildTarget(*root) && 
+            rootNode->TreeSize < MULTI_THREAD_REBUILD_POINT_NUM) {
+            cancelBackgroundRebuild(*root);
+        }
+        
+        bool needRebuild = allowRebuild && criterionCheck(rootNode);
+        if (needRebuild) {
+            rebuild(root);
+        }
+        
+        rootNode = node(*root);
+        if (rootNode != nullptr) {
+            rootNode->working_flag = false;
+        }
+        
+        return tmpCounter;
+    }
+
+    void addByRange(NodeIndex* root, const BoxType& boxpoint, bool allowRebuild) {
+        /**
+         * @brief 按包围盒添加实现 - 恢复指定范围内的点
+         */
+        KD_TREE_NODE* rootNode = node(*root);
+        if (rootNode == nullptr) return;
+        
+        rootNode->working_flag = true;
+        pushDown(rootNode);
+        
+        // 检查包围盒是否与节点范围相交
+        if (boxpoint.vertex_max[0] <= rootNode->node_range_x[0] || boxpoint.vertex_min[0] > rootNode->node_range_x[1]) return;
+        if (boxpoint.vertex_max[1] <= rootNode->node_range_y[0] || boxpoint.vertex_min[1] > rootNode->node_range_y[1]) return;
+        if (boxpoint.vertex_max[2] <= rootNode->node_range_z[0] || boxpoint.vertex_min[2] > rootNode->node_range_z[1]) return;
+        
+        // 如果包围盒完全包含节点范围，恢复整个子树
+        if (boxpoint.vertex_min[0] <= rootNode->node_range_x[0] && boxpoint.vertex_max[0] > rootNode->node_range_x[1] && 
+            boxpoint.vertex_min[1] <= rootNode->node_range_y[0] && boxpoint.vertex_max[1] > rootNode->node_range_y[1] && 
+            boxpoint.vertex_min[2] <= rootNode->node_range_z[0] && boxpoint.vertex_max[2] > rootNode->node_range_z[1]) {
+            
+            rootNode->tree_deleted = false || rootNode->tree_downsample_deleted;
+            rootNode->point_deleted = false || rootNode->point_downsample_deleted;
+            rootNode->need_push_down_to_left = true;
+            rootNode->need_push_down_to_right = true;
+            rootNode->invalid_point_num = rootNode->down_del_num;
+            return;
+        }
+        
+        // 部分相交的叶块先解冻，再逐点处理
+        if (rootNode->leaf_idx != 0) {
+            rootNode = thawLeafBlock(root);
+            rootNode->working_flag = true;
+            pushDown(rootNode);
+        }
+        
+        // 检查当前节点的点是否在包围盒内
+        if (boxpoint.vertex_min[0] <= rootNode->point.x && boxpoint.vertex_max[0] > rootNode->point.x && 
+            boxpoint.vertex_min[1] <= rootNode->point.y && boxpoint.vertex_max[1] > rootNode->point.y && 
+            boxpoint.vertex_min[2] <= rootNode->point.z && boxpoint.vertex_max[2] > rootNode->point.z) {
+            
+            rootNode->point_deleted = rootNode->point_downsample_deleted;
+        }
+        
+        Operation_Logger_Type addBoxLog;
+        addBoxLog.op = ADD_BOX;
+        addBoxLog.boxpoint = boxpoint;
+        
+        // 递归处理左子树
+        if (!isRebuildTarget(rootNode->left_son_idx)) {
+            addByRange(&(rootNode->left_son_idx), boxpoint, allowRebuild);
+        } else {
+            QMutexLocker workingLocker(&m_workingFlagMutex);
+            addByRange(&(rootNode->left_son_idx), boxpoint, false);
+            if (m_rebuildFlag.loadAcquire()) {
+                QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
+                m_rebuildLogger.push(addBoxLog);
+            }
+        }
+        
+        // 递归处理右子树
+        if (!isRebuildTarget(rootNode->right_son_idx)) {
+            addByRange(&(rootNode->right_son_idx), boxpoint, allowRebuild);
+        } else {
+            QMutexLocker workingLocker(&m_workingFlagMutex);
+            addByRange(&(rootNode->right_son_idx), boxpoint, false);
+            if (m_rebuildFlag.loadAcquire()) {
+                QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
+                m_rebuildLogger.push(addBoxLog);
+            }
+        }
+        
+        update(*root);
+        
+        if (isRebuildTarget(*root) && 
+            rootNode->TreeSize < MULTI_THREAD_REBUILD_POINT_NUM) {
+            cancelBackgroundRebuild(*root);
+        }
+        
+        bool needRebuild = allowRebuild && criterionCheck(rootNode);
+        if (needRebuild) {
+            rebuild(root);
+        }
+        
+        rootNode = node(*root);
+        if (rootNode != nullptr) {
+            rootNode->working_flag = false;
+        }
+    }
+
+    void rebuild(NodeIndex* root) {
+        /**
+         * @brief 重建子树实现 - 重新平衡树结构以提高性能
+         */
+        if (!root || *root == NULL_NODE) return;
+        
+        // 如果子树太小，不需要重建
+        if (node(*root)->TreeSize < Minimal_Unbalanced_Tree_Size) return;
+        
+        // 较大的子树交给后台重建
+        if constexpr (ThreadPolicy::kMultiThread) {
+            if (node(*root)->TreeSize >= MULTI_THREAD_REBUILD_POINT_NUM && requestBackgroundRebuild(*root)) return;
+        }
+        
+        // 收集所有有效点
+        PointVector storage;
+        flatten(*root, storage, NOT_RECORD);
+        
+        // 删除原有节点，保留父节点索引供新子树使用
+        NodeIndex fatherIdx = node(*root)->father_idx;
+        deleteTreeNodes(root);
+        
+        // 重新构建平衡的树
+        if (!storage.empty()) {
+            buildTree(root, 0, storage.size() - 1, storage);
+            if (*root != NULL_NODE) {
+                node(*root)->father_idx = fatherIdx;
+            }
+        }
+        if (root == &m_rootNode && m_staticRootNode != NULL_NODE) {
+            node(m_staticRootNode)->left_son_idx = m_rootNode;
+        }
+    }
+
+    void runOperation(NodeIndex* root, const Operation_Logger_Type& operation) {
+        switch (operation.op) {
+        case ADD_POINT:      
+            addByPoint(root, operation.point, false, (*root) != NULL_NODE ? node(*root)->division_axis : 0);          
+            break;
+        case ADD_BOX:
+            addByRange(root, operation.boxpoint, false);
+            break;
+        case DELETE_POINT:
+            deleteByPoint(root, operation.point, false);
+            break;
+        case DELETE_BOX:
+            deleteByRange(root, operation.boxpoint, false, false);
+            break;
+        case DOWNSAMPLE_DELETE:
+            deleteByRange(root, operation.boxpoint, false, true);
+            break;
+        case PUSH_DOWN:
+            node(*root)->tree_downsample_deleted |= operation.tree_downsample_deleted;
+            node(*root)->point_downsample_deleted |= operation.tree_downsample_deleted;
+            node(*root)->tree_deleted = operation.tree_deleted || node(*root)->tree_downsample_deleted;
+            node(*root)->point_deleted = node(*root)->tree_deleted || node(*root)->point_downsample_deleted;
+            if (operation.tree_downsample_deleted) node(*root)->down_del_num = node(*root)->TreeSize;
+            if (operation.tree_deleted) node(*root)->invalid_point_num = node(*root)->TreeSize;
+                else node(*root)->invalid_point_num = node(*root)->down_del_num;
+            node(*root)->need_push_down_to_left = true;
+            node(*root)->need_push_down_to_right = true;
+            break;
+        default:
+            break;
+        }
+    }
+
+    bool criterionCheck(KD_TREE_NODE* root) {
+        /**
+         * @brief 检查是否需要重建判据实现 - 判断树是否需要重建以保持平衡
+         */
+        if (root->TreeSize <= Minimal_Unbalanced_Tree_Size || root->leaf_idx != 0) {
+            return false;
+        }
+        
+        double balanceEvaluation = 0.0;
+        double deleteEvaluation = 0.0;
+        KD_TREE_NODE* sonPtr = node(root->left_son_idx);
+        if (sonPtr == nullptr) sonPtr = node(root->right_son_idx);
+        
+        deleteEvaluation = double(root->invalid_point_num) / root->TreeSize;
+        balanceEvaluation = double(sonPtr->TreeSize) / (root->TreeSize - 1);
+        
+        if (deleteEvaluation > m_deleteCriterionParam) {
+            return true;
+        }
+        
+        if (balanceEvaluation > m_balanceCriterionParam || balanceEvaluation < 1 - m_balanceCriterionParam) {
+            return true;
+        }
+        
+        return false;
+    }
+
+    void pushDown(KD_TREE_NODE* root) {
+        /**
+         * @brief 下推操作实现 - 将删除标记下推到子节点
+         */
+        if (root == nullptr) return;
+        
+        Operation_Logger_Type operation;
+        operation.op = PUSH_DOWN;
+        operation.tree_deleted = root->tree_deleted;
+        operation.tree_downsample_deleted = root->tree_downsample_deleted;
+        
+        if (root->need_push_down_to_left && root->left_son_idx != NULL_NODE) {
+            KD_TREE_NODE* leftSon = node(root->left_son_idx);
+            if (!isRebuildTarget(root->left_son_idx)) {
+                leftSon->tree_downsample_deleted |= root->tree_downsample_deleted;
+                leftSon->point_downsample_deleted |= root->tree_downsample_deleted;
+                leftSon->tree_deleted = root->tree_deleted || leftSon->tree_downsample_deleted;
+                leftSon->point_deleted = leftSon->tree_deleted || leftSon->point_downsample_deleted;
+                if (root->tree_downsample_deleted) leftSon->down_del_num = leftSon->TreeSize;
+                if (root->tree_deleted) leftSon->invalid_point_num = leftSon->TreeSize;
+                    else leftSon->invalid_point_num = leftSon->down_del_num;
+                leftSon->need_push_down_to_left = true;
+                leftSon->need_push_down_to_right = true;
+                root->need_push_down_to_left = false;
+            } else {
+                QMutexLocker locker(&m_workingFlagMutex);
+                leftSon->tree_downsample_deleted |= root->tree_downsample_deleted;
+                leftSon->point_downsample_deleted |= root->tree_downsample_deleted;
+                leftSon->tree_deleted = root->tree_deleted || leftSon->tree_downsample_deleted;
+                leftSon->point_deleted = leftSon->tree_deleted || leftSon->point_downsample_deleted;
+                if (root->tree_downsample_deleted) leftSon->down_del_num = leftSon->TreeSize;
+                if (root->tree_deleted) leftSon->invalid_point_num = leftSon->TreeSize;
+                    else leftSon->invalid_point_num = leftSon->down_del_num;
+                leftSon->need_push_down_to_left = true;
+                leftSon->need_push_down_to_right = true;
+                if (m_rebuildFlag.loadAcquire()) {
+                    QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
+                    m_rebuildLogger.push(operation);
+                }
+                root->need_push_down_to_left = false;
+            }
+        }
+        
+        if (root->need_push_down_to_right && root->right_son_idx != NULL_NODE) {
+            KD_TREE_NODE* rightSon = node(root->right_son_idx);
+            if (!isRebuildTarget(root->right_son_idx)) {
+                rightSon->tree_downsample_deleted |= root->tree_downsample_deleted;
+                rightSon->point_downsample_deleted |= root->tree_downsample_deleted;
+                rightSon->tree_deleted = root->tree_deleted || rightSon->tree_downsample_deleted;
+                rightSon->point_deleted = rightSon->tree_deleted || rightSon->point_downsample_deleted;
+                if (root->tree_downsample_deleted) rightSon->down_del_num = rightSon->TreeSize;
+                if (root->tree_deleted) rightSon->invalid_point_num = rightSon->TreeSize;
+                    else rightSon->invalid_point_num = rightSon->down_del_num;
+                rightSon->need_push_down_to_left = true;
+                rightSon->need_push_down_to_right = true;
+                root->need_push_down_to_right = false;
+            } else {
+                QMutexLocker locker(&m_workingFlagMutex);
+                rightSon->tree_downsample_deleted |= root->tree_downsample_deleted;
+                rightSon->point_downsample_deleted |= root->tree_downsample_deleted;
+                rightSon->tree_deleted = root->tree_deleted || rightSon->tree_downsample_deleted;
+                rightSon->point_deleted = rightSon->tree_deleted || rightSon->point_downsample_deleted;
+                if (root->tree_downsample_deleted) rightSon->down_del_num = rightSon->TreeSize;
+                if (root->tree_deleted) rightSon->invalid_point_num = rightSon->TreeSize;
+                    else rightSon->invalid_point_num = rightSon->down_del_num;
+                rightSon->need_push_down_to_left = true;
+                rightSon->need_push_down_to_right = true;
+                if (m_rebuildFlag.loadAcquire()) {
+                    QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
+                    m_rebuildLogger.push(operation);
+                }
+                root->need_push_down_to_right = false;
+            }
+        }
+    }
+
+    void update(NodeIndex rootIdx) {
+        /**
+         * @brief 更新节点信息实现 - 更新统计信息和包围盒
+         */
+        if (rootIdx == NULL_NODE) return;
+        
+        KD_TREE_NODE* root = node(rootIdx);
+        // 叶块的统计信息与包围盒在构建和追加时确定，删除标志由下推维护
+        if (root->leaf_idx != 0) return;
+        
+        KD_TREE_NODE* leftSonPtr = node(root->left_son_idx);
+        KD_TREE_NODE* rightSonPtr = node(root->right_son_idx);
+        // 空子节点以单位元代替，三种子节点组合共用同一套合并计算
+        const MERGE_IDENTITY& identity = mergeIdentity();
+        const KD_TREE_NODE* leftSon = leftSonPtr != nullptr ? leftSonPtr : &identity.son;
+        const KD_TREE_NODE* rightSon = rightSonPtr != nullptr ? rightSonPtr : &identity.son;
+        
+        // 更新树大小和删除标志
+        root->TreeSize = leftSon->TreeSize + rightSon->TreeSize + 1;
+        root->invalid_point_num = leftSon->invalid_point_num + rightSon->invalid_point_num + int(root->point_deleted);
+        root->down_del_num = leftSon->down_del_num + rightSon->down_del_num + int(root->point_downsample_deleted);
+        root->tree_downsample_deleted = leftSon->tree_downsample_deleted & rightSon->tree_downsample_deleted & root->point_downsample_deleted;
+        root->tree_deleted = leftSon->tree_deleted & rightSon->tree_deleted & root->point_deleted;
+        
+        // 子树整体删除时合并全部范围，否则只合并未删除的部分；不参与合并的来源换成单位元，
+        // 按左、右、节点点的原顺序取min/max，结果与逐项判断相同
+        const bool takePoint = root->tree_deleted | !root->point_deleted;
+        const KD_TREE_NODE* leftBox = (root->tree_deleted | !leftSon->tree_deleted) ? leftSon : &identity.son;
+        const KD_TREE_NODE* rightBox = (root->tree_deleted | !rightSon->tree_deleted) ? rightSon : &identity.son;
+        const PointType& pointLo = takePoint ? root->point : identity.lowPoint;
+        const PointType& pointHi = takePoint ? root->point : identity.highPoint;
+        // 按值比较，qMin/qMax返回引用会让编译器生成地址选择而非min/max指令
+        auto minOf = [](Scalar a, Scalar b) { return a < b ? a : b; };
+        auto maxOf = [](Scalar a, Scalar b) { return a < b ? b : a; };
+        const Scalar rangeX0 = minOf(minOf(leftBox->node_range_x[0], rightBox->node_range_x[0]), pointLo.x);
+        const Scalar rangeX1 = maxOf(maxOf(leftBox->node_range_x[1], rightBox->node_range_x[1]), pointHi.x);
+        const Scalar rangeY0 = minOf(minOf(leftBox->node_range_y[0], rightBox->node_range_y[0]), pointLo.y);
+        const Scalar rangeY1 = maxOf(maxOf(leftBox->node_range_y[1], rightBox->node_range_y[1]), pointHi.y);
+        const Scalar rangeZ0 = minOf(minOf(leftBox->node_range_z[0], rightBox->node_range_z[0]), pointLo.z);
+        const Scalar rangeZ1 = maxOf(maxOf(leftBox->node_range_z[1], rightBox->node_range_z[1]), pointHi.z);
+        root->node_range_x[0] = rangeX0;
+        root->node_range_x[1] = rangeX1;
+        root->node_range_y[0] = rangeY0;
+        root->node_range_y[1] = rangeY1;
+        root->node_range_z[0] = rangeZ0;
+        root->node_range_z[1] = rangeZ1;
+        
+        if (leftSonPtr != nullptr) leftSonPtr->father_idx = rootIdx;
+        if (rightSonPtr != nullptr) rightSonPtr->father_idx = rootIdx;
+        
+        if (rootIdx == m_rootNode && root->TreeSize > 3) {
+            KD_TREE_NODE* sonPtr = leftSonPtr;
+            if (sonPtr == nullptr) sonPtr = rightSonPtr;
+            double tmpBal = double(sonPtr->TreeSize) / (root->TreeSize - 1);
+            m_rootAlphaDel = double(root->invalid_point_num) / root->TreeSize;
+            m_rootAlphaBal = (tmpBal >= 0.5 - EPSS) ? tmpBal : 1 - tmpBal;
+        }
+    }
+
+    void deleteTreeNodes(NodeIndex* root) {
+        /**
+         * @brief 删除树节点实现 - 以显式栈后序释放整个子树，释放顺序与递归版本相同
+         */
+        TraversalStack<VISIT_FRAME> stack;
+        stack.append(VISIT_FRAME{*root, false, root});
+        while (!stack.isEmpty()) {
+            NodeIndex index = stack.last().index;
+            const bool post = stack.last().post;
+            NodeIndex* slot = stack.last().slot;
+            stack.removeLast();
+            if (!post) {
+                // 沿左链直接下降，右子树和后序帧入栈
+                while (index != NULL_NODE) {
+                    KD_TREE_NODE* rootNode = node(index);
+                    pushDown(rootNode);
+                    stack.append(VISIT_FRAME{index, true, slot});
+                    if (rootNode->right_son_idx != NULL_NODE) {
+                        stack.append(VISIT_FRAME{rootNode->right_son_idx, false, &rootNode->right_son_idx});
+                    }
+                    slot = &rootNode->left_son_idx;
+                    index = *slot;
+                }
+                continue;
+            }
+            
+            KD_TREE_NODE* rootNode = node(index);
+            if (rootNode->leaf_idx != 0) releaseLeafBlock(rootNode->leaf_idx);
+            m_nodePool.release(index);
+            *slot = NULL_NODE;
+        }
+    }
+
+    void releaseDetachedTree(NodeIndex root) {
+        /**
+         * @brief 回收已摘下子树实现 - 不下推标记也不清子节点索引，只有release写节点
+         */
+        TraversalStack<NodeIndex> stack;
+        if (root != NULL_NODE) stack.append(root);
+        while (!stack.isEmpty()) {
+            const NodeIndex index = stack.last();
+            stack.removeLast();
+            const KD_TREE_NODE* rootNode = m_nodePool.node(index);
+            if (rootNode->left_son_idx != NULL_NODE) stack.append(rootNode->left_son_idx);
+            if (rootNode->right_son_idx != NULL_NODE) stack.append(rootNode->right_son_idx);
+            if (rootNode->leaf_idx != 0) releaseLeafBlock(rootNode->leaf_idx);
+            m_nodePool.release(index);
+        }
+    }
+
+    bool samePoint(const PointType& a, const PointType& b) const {
+        /**
+         * @brief 判断点是否相同实现
+         */
+        return (qAbs(a.x - b.x) < EPSS && qAbs(a.y - b.y) < EPSS && qAbs(a.z - b.z) < EPSS);
+    }
+
+    Scalar calcDist(const PointType& a, const PointType& b) const {
+        /**
+         * @brief 计算点间距离实现 - 以坐标标量精度计算
+         */
+        Scalar dist = (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z);
+        return dist;
+    }
+
+    Scalar calcBoxDist(const KD_TREE_NODE* node, const PointType& point) const {
+        /**
+         * @brief 计算点到包围盒距离实现 - 以坐标标量精度计算
+         * 
+         * 每轴取max(lo - p, p - hi, 0)的平方，无数据相关分支，结果与逐项判断相同
+         */
+        if (node == nullptr) return std::numeric_limits<Scalar>::infinity();
+        
+        Scalar dx = qMax(qMax(node->node_range_x[0] - point.x, point.x - node->node_range_x[1]), Scalar(0));
+        Scalar dy = qMax(qMax(node->node_range_y[0] - point.y, point.y - node->node_range_y[1]), Scalar(0));
+        Scalar dz = qMax(qMax(node->node_range_z[0] - point.z, point.z - node->node_range_z[1]), Scalar(0));
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    void calcSonBoxDist(const KD_TREE_NODE* root, const PointType& point, Scalar& distLeft, Scalar& distRight) const {
+        /**
+         * @brief 同时计算点到左右子节点包围盒的距离实现
+         * 
+         * 两个子节点的包围盒排成2组×4通道（第4通道补零），一次无分支循环完成，可由编译器向量化；
+         * 空子节点用上下界颠倒的无穷包围盒代替，距离为无穷大
+         */
+        constexpr Scalar INF = std::numeric_limits<Scalar>::infinity();
+        const KD_TREE_NODE* sons[2] = {node(root->left_son_idx), node(root->right_son_idx)};
+        alignas(32) Scalar lo[8], hi[8];
+        const Scalar p[8] = {point.x, point.y, point.z, 0, point.x, point.y, point.z, 0};
+        for (int c = 0; c < 2; c++) {
+            const KD_TREE_NODE* son = sons[c];
+            lo[4 * c + 0] = son ? son->node_range_x[0] : INF;
+            lo[4 * c + 1] = son ? son->node_range_y[0] : INF;
+            lo[4 * c + 2] = son ? son->node_range_z[0] : INF;
+            hi[4 * c + 0] = son ? son->node_range_x[1] : -INF;
+            hi[4 * c + 1] = son ? son->node_range_y[1] : -INF;
+            hi[4 * c + 2] = son ? son->node_range_z[1] : -INF;
+            lo[4 * c + 3] = 0;
+            hi[4 * c + 3] = 0;
+        }
+        Scalar d[8];
+        for (int i = 0; i < 8; i++) {
+            Scalar e = qMax(qMax(lo[i] - p[i], p[i] - hi[i]), Scalar(0));
+            d[i] = e * e;
+        }
+        distLeft = d[0] + d[1] + d[2];
+        distRight = d[4] + d[5] + d[6];
+    }
+
+    Scalar nodeRadiusSq(const KD_TREE_NODE* node) const {
+        /**
+         * @brief 计算节点包围球半径平方实现 - 由包围盒半边长即时求得
+         */
+        Scalar xL = (node->node_range_x[1] - node->node_range_x[0]) * Scalar(0.5);
+        Scalar yL = (node->node_range_y[1] - node->node_range_y[0]) * Scalar(0.5);
+        Scalar zL = (node->node_range_z[1] - node->node_range_z[0]) * Scalar(0.5);
+        return xL*xL + yL*yL + zL*zL;
+    }
+
+    static bool pointCmpX(const PointType& a, const PointType& b) {
+        return a.x < b.x;
+    }
+
+    static bool pointCmpY(const PointType& a, const PointType& b) {
+        return a.y < b.y;
+    }
+
+    static bool pointCmpZ(const PointType& a, const PointType& b) {
+        return a.z < b.z;
+    }
+};
+
+/**
+ * @brief 附加数据分离存储的K-D树 - 树内只保存坐标和32位点编号
+ *
+ * 强度、时间戳、法向量等较大的附加数据保存在按点编号索引的侧表中，
+ * 建树时的nth_element、展平、重建和搜索结果只搬运坐标与编号，开销与附加数据大小无关。
+ * 搜索结果的data成员即点编号，需要时通过payload()或gatherPayloads()取回附加数据的副本。
+ * 编号在插入时分配，不随重建变化，可直接按编号删除或移动点。被删除或下采样合并的点仍占用编号和侧表槽位，
+ * 直到调用reclaimRemovedIds()：它清空这些槽位的附加数据，之后的addPoints()优先复用这些编号。
+ * 复用规则：调用reclaimRemovedIds()之前已被删除的点的编号，调用之后可能指向新插入的点，调用者应在此前丢弃这些编号。
+ * 并发约定与KD_TREE相同。build()、addPoints()和movePoint()持有包装层写锁完成侧表与树的全部修改，
+ * 查询和取回附加数据持有读锁，看不到编号与侧表不一致或点暂时缺失的中间状态
+ * @tparam Payload 附加数据类型
+ * @tparam Scalar 坐标标量类型
+ * @tparam ThreadPolicy 线程策略
+ */
+template<typename Payload, typename Scalar = double, typename ThreadPolicy = MultiThreaded>
+class KD_TREE_PAYLOAD
+{
+public:
+    using PointType = ikdTree_PointType<PointId, Scalar>;   ///< 树内点类型，data为点编号
+    using TreeType = KD_TREE<PointType, ThreadPolicy>;      ///< 内部K-D树类型
+    using PointVector = typename TreeType::PointVector;     ///< 点向量类型
+    using BoxType = typename TreeType::BoxType;             ///< 包围盒类型
+    using APPROXIMATE_SEARCH = typename TreeType::APPROXIMATE_SEARCH; ///< 近似K近邻参数
+    using SEARCH_LIMIT = typename TreeType::SEARCH_LIMIT;   ///< 查询时限
+    using PayloadVector = QVector<Payload>;                 ///< 附加数据向量类型
+    using ReadLocker = typename TreeType::ReadLocker;       ///< 读锁守卫
+    using WriteLocker = typename TreeType::WriteLocker;     ///< 写锁守卫
+
+    /**
+     * @brief 构造函数 - 参数含义与KD_TREE相同
+     */
+    explicit KD_TREE_PAYLOAD(double deleteParam = 0.5, double balanceParam = 0.6, double boxLength = 0.2)
+        : m_tree(deleteParam, balanceParam, boxLength)
+    {
+        m_tree.setPointIdTracking(true);
+    }
+
+    /**
+     * @brief 构建树 - 丢弃已有的点和附加数据，编号从0开始按输入顺序分配
+     * @param points 点坐标，data成员被忽略
+     * @param payloads 与points一一对应的附加数据
+     */
+    void build(const PointVector& points, const PayloadVector& payloads)
+    {
+        /**
+         * @brief 构建树实现
+         */
+        Q_ASSERT(points.size() == payloads.size());
+        PointVector idPoints = points;
+        for (int i = 0; i < idPoints.size(); i++) idPoints[i].data = PointId(i);
+        WriteLocker payloadLocker(&m_payloadLock);
+        m_payloads = payloads;
+        m_freeIds.clear();
+        m_tree.build(idPoints);
+    }
+
+    /**
+     * @brief 添加点集合
+     * @param points 点坐标，data成员被忽略
+     * @param payloads 与points一一对应的附加数据
+     * @param downsampleOn 是否启用下采样
+     * @param ids 输出每个输入点分配到的编号，可为nullptr
+     * @return 与KD_TREE::addPoints相同
+     */
+    int addPoints(const PointVector& points, const PayloadVector& payloads, bool downsampleOn, QVector<PointId>* ids = nullptr)
+    {
+        /**
+         * @brief 添加点集合实现 - 在同一把写锁内登记附加数据并插入坐标，先复用已回收的编号
+         */
+        Q_ASSERT(points.size() == payloads.size());
+        PointVector idPoints = points;
+        if (ids) ids->resize(points.size());
+        WriteLocker payloadLocker(&m_payloadLock);
+        for (int i = 0; i < idPoints.size(); i++) {
+            if (!m_freeIds.isEmpty()) {
+                idPoints[i].data = m_freeIds.takeLast();
+                m_payloads[int(idPoints[i].data)] = payloads[i];
+            } else {
+                idPoints[i].data = PointId(m_payloads.size());
+                m_payloads.append(payloads[i]);
+            }
+            if (ids) (*ids)[i] = idPoints[i].data;
+        }
+        return m_tree.addPoints(idPoints, downsampleOn);
+    }
+
+    /**
+     * @brief 按坐标删除点集合，附加数据保留在侧表中
+     */
+    void deletePoints(PointVector& pointToDel)
+    {
+        m_tree.deletePoints(pointToDel);
+    }
+
+    /**
+     * @brief 按编号删除点，无需提供坐标
+     * @return 点存在且此前未被删除时返回true
+     */
+    bool deletePointById(PointId id)
+    {
+        return m_tree.deletePointById(id);
+    }
+
+    /**
+     * @brief 按编号批量删除点
+     * @param deletedIds 非空时追加实际删除的编号
+     * @return 实际删除的点数
+     */
+    int deletePointsById(const QVector<PointId>& ids, QVector<PointId>* deletedIds = nullptr)
+    {
+        return m_tree.deletePointsById(ids, deletedIds);
+    }
+
+    /**
+     * @brief 移动点到新坐标，编号和附加数据不变
+     * @return 点存在且未被删除时返回true
+     */
+    bool movePoint(PointId id, const PointType& position)
+    {
+        /**
+         * @brief 移动点实现 - 在同一把写锁内按编号删除旧节点，再以同一编号重新插入
+         */
+        WriteLocker payloadLocker(&m_payloadLock);
+        if (!m_tree.deletePointById(id)) return false;
+        PointVector pointToAdd;
+        pointToAdd.append(position);
+        pointToAdd[0].data = id;
+        m_tree.addPoints(pointToAdd, false);
+        return true;
+    }
+
+    /**
+     * @brief K近邻搜索，结果点的data成员为点编号
+     */
+    void nearestSearch(const PointType& point, int kNearest, PointVector& nearestPoints,
+                       QVector<double>& pointDistance, double maxDist = std::numeric_limits<double>::infinity(),
+                       int* visitedNodes = nullptr) const
+    {
+        ReadLocker payloadLocker(&m_payloadLock);
+        m_tree.nearestSearch(point, kNearest, nearestPoints, pointDistance, maxDist, visitedNodes);
+    }
+
+    /**
+     * @brief 近似K近邻搜索，结果点的data成员为点编号
+     */
+    void nearestSearch(const PointType& point, int kNearest, PointVector& nearestPoints, QVector<double>& pointDistance,
+                       const APPROXIMATE_SEARCH& approximate, double maxDist = std::numeric_limits<double>::infinity(),
+                       int* visitedNodes = nullptr) const
+    {
+        ReadLocker payloadLocker(&m_payloadLock);
+        m_tree.nearestSearch(point, kNearest, nearestPoints, pointDistance, approximate, maxDist, visitedNodes);
+    }
+
+    /**
+     * @brief 带时限的K近邻搜索，结果点的data成员为点编号，返回是否被截断
+     */
+    bool nearestSearch(const PointType& point, int kNearest, PointVector& nearestPoints, QVector<double>& pointDistance,
+                       const SEARCH_LIMIT& limit, double maxDist = std::numeric_limits<double>::infinity(),
+                       int* visitedNodes = nullptr) const
+    {
+        ReadLocker payloadLocker(&m_payloadLock);
+        return m_tree.nearestSearch(point, kNearest, nearestPoints, pointDistance, limit, maxDist, visitedNodes);
+    }
+
+    /**
+     * @brief 批量K近邻搜索，结果点的data成员为点编号
+     */
+    void nearestSearchBatch(const PointVector& queries, int kNearest, QVector<PointVector>& nearestPoints,
+                            QVector<QVector<double>>& pointDistances,
+                            double maxDist = std::numeric_limits<double>::infinity()) const
+    {
+        ReadLocker payloadLocker(&m_payloadLock);
+        m_tree.nearestSearchBatch(queries, kNearest, nearestPoints, pointDistances, maxDist);
+    }
+
+    /**
+     * @brief 近似批量K近邻搜索，结果点的data成员为点编号
+     */
+    void nearestSearchBatch(const PointVector& queries, int kNearest, QVector<PointVector>& nearestPoints,
+                            QVector<QVector<double>>& pointDistances, const APPROXIMATE_SEARCH& approximate,
+                            double maxDist = std::numeric_limits<double>::infinity()) const
+    {
+        ReadLocker payloadLocker(&m_payloadLock);
+        m_tree.nearestSearchBatch(queries, kNearest, nearestPoints, pointDistances, approximate, maxDist);
+    }
+
+    /**
+     * @brief 半径搜索，结果点的data成员为点编号
+     */
+    void radiusSearch(const PointType& point, double radius, PointVector& storage) const
+    {
+        ReadLocker payloadLocker(&m_payloadLock);
+        m_tree.radiusSearch(point, radius, storage);
+    }
+
+    /**
+     * @brief 包围盒搜索，结果点的data成员为点编号
+     */
+    void boxSearch(const BoxType& boxOfPoint, PointVector& storage) const
+    {
+        ReadLocker payloadLocker(&m_payloadLock);
+        m_tree.boxSearch(boxOfPoint, storage);
+    }
+
+    /**
+     * @brief 带时限的半径搜索，结果点的data成员为点编号，返回是否被截断
+     */
+    bool radiusSearch(const PointType& point, double radius, PointVector& storage, const SEARCH_LIMIT& limit) const
+    {
+        ReadLocker payloadLocker(&m_payloadLock);
+        return m_tree.radiusSearch(point, radius, storage, limit);
+    }
+
+    /**
+     * @brief 带时限的包围盒搜索，结果点的data成员为点编号，返回是否被截断
+     */
+    bool boxSearch(const BoxType& boxOfPoint, PointVector& storage, const SEARCH_LIMIT& limit) const
+    {
+        ReadLocker payloadLocker(&m_payloadLock);
+        return m_tree.boxSearch(boxOfPoint, storage, limit);
+    }
+
+    /**
+     * @brief 获取点编号对应的附加数据 - 返回副本，写线程随后扩充侧表不影响调用者
+     */
+    Payload payload(PointId id) const
+    {
+        ReadLocker payloadLocker(&m_payloadLock);
+        return m_payloads.at(int(id));
+    }
+
+    /**
+     * @brief 修改点编号对应的附加数据
+     */
+    void setPayload(PointId id, const Payload& payload)
+    {
+        WriteLocker payloadLocker(&m_payloadLock);
+        m_payloads[int(id)] = payload;
+    }
+
+    /**
+     * @brief 批量取回搜索结果的附加数据
+     * @param points 搜索结果
+     * @param payloads 输出与points一一对应的附加数据
+     */
+    void gatherPayloads(const PointVector& points, PayloadVector& payloads) const
+    {
+        /**
+         * @brief 批量取回附加数据实现
+         */
+        ReadLocker payloadLocker(&m_payloadLock);
+        payloads.clear();
+        payloads.reserve(points.size());
+        for (const PointType& point : points) payloads.append(m_payloads.at(int(point.data)));
+    }
+
+    /**
+     * @brief 侧表槽位数，即已分配过的最大编号加1，包括等待复用的编号
+     */
+    int payloadCount() const
+    {
+        ReadLocker payloadLocker(&m_payloadLock);
+        return m_payloads.size();
+    }
+
+    /**
+     * @brief 回收已不在树中的点的编号
+     *
+     * 树中有效点的编号之外的槽位（被删除、被下采样合并或插入时被下采样丢弃的点）清空附加数据，
+     * 末尾连续的空闲槽位直接从侧表截去，其余编号由之后的addPoints()优先复用，较小的编号先被复用。
+     * 调用后这些编号可能指向新插入的点。需要遍历整棵树，适合在地图维护间隙调用
+     * @return 空闲编号数，包括被截去的槽位
+     */
+    int reclaimRemovedIds()
+    {
+        /**
+         * @brief 回收编号实现 - 以包围全部坐标的包围盒搜索标记有效编号
+         */
+        WriteLocker payloadLocker(&m_payloadLock);
+        BoxType everything;
+        for (int axis = 0; axis < 3; axis++) {
+            everything.vertex_min[axis] = -std::numeric_limits<Scalar>::infinity();
+            everything.vertex_max[axis] = std::numeric_limits<Scalar>::infinity();
+        }
+        PointVector livePoints;
+        m_tree.boxSearch(everything, livePoints);
+        QVector<bool> live(m_payloads.size(), false);
+        for (const PointType& point : livePoints) live[int(point.data)] = true;
+        
+        const int slotCount = m_payloads.size();
+        int liveEnd = slotCount;
+        while (liveEnd > 0 && !live[liveEnd - 1]) liveEnd--;
+        m_payloads.resize(liveEnd);
+        m_freeIds.clear();
+        for (int id = liveEnd - 1; id >= 0; id--) {
+            if (live[id]) continue;
+            m_payloads[id] = Payload();
+            m_freeIds.append(PointId(id));
+        }
+        return m_freeIds.size() + slotCount - liveEnd;
+    }
+
+    /**
+     * @brief 获取树大小
+     */
+    int size() const
+    {
+        return m_tree.size();
+    }
+
+    /**
+     * @brief 获取有效节点数
+     */
+    int validnum() const
+    {
+        return m_tree.validnum();
+    }
+
+    /**
+     * @brief 访问内部K-D树，用于包围盒删除、压缩叶块等设置；直接修改内部树不经过包装层的锁
+     */
+    TreeType& tree()
+    {
+        return m_tree;
+    }
+
+private:
+    TreeType m_tree;            ///< 只含坐标和编号的K-D树
+    PayloadVector m_payloads;   ///< 附加数据侧表，按点编号索引
+    QVector<PointId> m_freeIds; ///< 等待复用的编号，末尾为最小编号
+    mutable typename TreeType::ReadWriteLock m_payloadLock; ///< 包装层读写锁，保护侧表及其与树的组合修改
+};
+
+/**
+ * @brief 空间分片的K-D树森林 - 按xy平面网格划分空间，每个分片一棵独立的KD_TREE
+ *
+ * 城市级地图中单棵树的根节点既是写锁竞争点也是重建热点。森林把点按坐标路由到边长shardSize的网格单元，
+ * 分片在第一次有点落入时创建，各自加锁、各自重建。build、addPoints、deletePoints、deletePointBoxes以及
+ * boxSearch、radiusSearch按涉及的分片分组后在线程池中并行执行，结果按分片键顺序拼接。
+ * K近邻从查询点所在分片开始按环向外扩展，只有分片到查询点的平面距离小于当前第k近距离时才进入该分片。
+ * shardSize取整为下采样边长的整数倍，点按所在的下采样体素路由，同一体素的点总在同一分片，
+ * 分片只含其网格单元内的点，删除、区域查询和K近邻的距离下界都依赖这一点。
+ * 并发约定：每个分片沿用KD_TREE的单写多读约定；addPoints、deletePoints、deletePointBoxes之间可以并发，
+ * build与它们互斥。单个分片内看到的总是完整状态，跨分片的查询不是原子的，可能看到一次写操作只在部分分片上完成
+ * @tparam PointType 点类型
+ * @tparam ThreadPolicy 线程策略，SingleThreaded时不使用线程池，各分片在调用线程内依次处理
+ */
+template<typename PointType, typename ThreadPolicy = MultiThreaded>
+class KD_TREE_FOREST
+{
+public:
+    using TreeType = KD_TREE<PointType, ThreadPolicy>;      ///< 分片K-D树类型
+    using TreePtr = typename TreeType::Ptr;                 ///< 分片智能指针类型
+    using PointVector = typename TreeType::PointVector;     ///< 点向量类型
+    using BoxType = typename TreeType::BoxType;             ///< 包围盒类型
+    using ReadLocker = typename TreeType::ReadLocker;       ///< 读锁守卫
+    using WriteLocker = typename TreeType::WriteLocker;     ///< 写锁守卫
+    
+    static constexpr int NEAREST_BATCH_CHUNK = 16;          ///< 批量K近邻中每个任务处理的查询数
+    
+    /**
+     * @brief 构造函数
+     * @param shardSize 分片网格边长，取整为boxLength的整数倍，至少为一个体素
+     * @param deleteParam 各分片的删除判据参数
+     * @param balanceParam 各分片的平衡判据参数
+     * @param boxLength 各分片的下采样边长
+     */
+    explicit KD_TREE_FOREST(double shardSize = 50.0, double deleteParam = 0.5, double balanceParam = 0.6,
+                            double boxLength = 0.2)
+        : m_cellVoxels(boxLength > 0.0 ? qMax(1, qRound(shardSize / boxLength)) : 0),
+          m_shardSize(m_cellVoxels > 0 ? m_cellVoxels * boxLength : shardSize),
+          m_deleteParam(deleteParam), m_balanceParam(balanceParam), m_boxLength(boxLength)
+    {
+        setThreadCount(QThread::idealThreadCount());
+    }
+    
+    /**
+     * @brief 设置并行处理分片的线程数，包括调用线程本身
+     */
+    void setThreadCount(int threadCount)
+    {
+        m_threadCount = qMax(1, threadCount);
+        m_threadPool.setMaxThreadCount(qMax(1, m_threadCount - 1));
+    }
+    
+    /**
+     * @brief 获取并行处理分片的线程数
+     */
+    int threadCount() const
+    {
+        return m_threadCount;
+    }
+    
+    /**
+     * @brief 获取分片网格边长，已取整为下采样边长的整数倍
+     */
+    double shardSize() const
+    {
+        return m_shardSize;
+    }
+    
+    /**
+     * @brief 获取已创建的分片数
+     */
+    int shardCount() const
+    {
+        return indexSnapshot().shards.size();
+    }
+    
+    /**
+     * @brief 构建森林 - 丢弃已有分片，按网格分组后并行建树
+     */
+    void build(const PointVector& pointCloud)
+    {
+        /**
+         * @brief 构建森林实现 - 新分片建好后一次性替换分片表；持构建锁的写模式，
+         * 其他写方法不会把点写入即将被替换的分片
+         */
+        WriteLocker buildLocker(&m_buildLock);
+        QVector<SHARD_BATCH> batches;
+        groupPoints(pointCloud, batches);
+        SHARD_INDEX index;
+        for (SHARD_BATCH& batch : batches) {
+            batch.tree = createShard();
+            insertShard(index, batch.key, batch.tree);
+        }
+        runParallel(batches.size(), [&](int i) { batches[i].tree->build(batches[i].points); });
+        WriteLocker indexLocker(&m_indexLock);
+        m_index = index;
+    }
+    
+    /**
+     * @brief 添加点集合 - 按分片分组后并行插入
+     * @return 各分片addPoints返回值之和
+     */
+    int addPoints(PointVector& pointToAdd, bool downsampleOn)
+    {
+        /**
+         * @brief 添加点集合实现 - 缺少的分片先创建
+         */
+        ReadLocker buildLocker(&m_buildLock);
+        QVector<SHARD_BATCH> batches;
+        groupPoints(pointToAdd, batches);
+        acquireShards(batches);
+        QVector<int> counters(batches.size(), 0);
+        runParallel(batches.size(), [&](int i) { counters[i] = batches[i].tree->addPoints(batches[i].points, downsampleOn); });
+        int tmpCounter = 0;
+        for (int counter : counters) tmpCounter += counter;
+        return tmpCounter;
+    }
+    
+    /**
+     * @brief 删除点集合 - 按分片分组后并行删除，落在不存在分片中的点被忽略
+     */
+    void deletePoints(PointVector& pointToDel)
+    {
+        /**
+         * @brief 删除点集合实现
+         */
+        ReadLocker buildLocker(&m_buildLock);
+        QVector<SHARD_BATCH> batches;
+        groupPoints(pointToDel, batches);
+        const SHARD_INDEX index = indexSnapshot();
+        for (SHARD_BATCH& batch : batches) batch.tree = index.shards.value(batch.key);
+        runParallel(batches.size(), [&](int i) {
+            if (batches[i].tree) batches[i].tree->deletePoints(batches[i].points);
+        });
+    }
+    
+    /**
+     * @brief 删除包围盒内的点 - 每个包围盒交给与其相交的全部分片
+     * @return 删除的点数
+     */
+    int deletePointBoxes(QVector<BoxType>& boxPoints)
+    {
+        /**
+         * @brief 删除包围盒内的点实现
+         */
+        ReadLocker buildLocker(&m_buildLock);
+        const SHARD_INDEX index = indexSnapshot();
+        QVector<SHARD_BATCH> batches;
+        QHash<quint64, int> batchOfKey;
+        QVector<SHARD_BATCH> shards;
+        for (const BoxType& box : boxPoints) {
+            collectShards(index, box.vertex_min[0], box.vertex_min[1], box.vertex_max[0], box.vertex_max[1], shards);
+            for (const SHARD_BATCH& shard : shards) {
+                int& slot = batchOfKey[shard.key];
+                if (slot == 0) {
+                    batches.append(shard);
+                    slot = batches.size();
+                }
+                batches[slot - 1].boxes.append(box);
+            }
+        }
+        QVector<int> counters(batches.size(), 0);
+        runParallel(batches.size(), [&](int i) { counters[i] = batches[i].tree->deletePointBoxes(batches[i].boxes); });
+        int tmpCounter = 0;
+        for (int counter : counters) tmpCounter += counter;
+        return tmpCounter;
+    }
+    
+    /**
+     * @brief 包围盒搜索 - 相交的分片并行搜索，结果按分片键顺序拼接
+     */
+    void boxSearch(const BoxType& boxOfPoint, PointVector& storage) const
+    {
+        /**
+         * @brief 包围盒搜索实现
+         */
+        QVector<SHARD_BATCH> shards;
+        collectShards(indexSnapshot(), boxOfPoint.vertex_min[0], boxOfPoint.vertex_min[1],
+                      boxOfPoint.vertex_max[0], boxOfPoint.vertex_max[1], shards);
+        runParallel(shards.size(), [&](int i) { shards[i].tree->boxSearch(boxOfPoint, shards[i].points); });
+        concatenate(shards, storage);
+    }
+    
+    /**
+     * @brief 半径搜索 - 与查询球相交的分片并行搜索，结果按分片键顺序拼接
+     */
+    void radiusSearch(const PointType& point, double radius, PointVector& storage) const
+    {
+        /**
+         * @brief 半径搜索实现 - 先按外接正方形取分片，再剔除到查询点距离超过半径的分片
+         */
+        QVector<SHARD_BATCH> shards;
+        collectShards(indexSnapshot(), point.x - radius, point.y - radius, point.x + radius, point.y + radius, shards);
+        int kept = 0;
+        for (int i = 0; i < shards.size(); i++) {
+            if (cellDistance(point, shards[i].key) <= radius * radius) shards[kept++] = shards[i];
+        }
+        shards.resize(kept);
+        runParallel(shards.size(), [&](int i) { shards[i].tree->radiusSearch(point, radius, shards[i].points); });
+        concatenate(shards, storage);
+    }
+    
+    /**
+     * @brief K近邻搜索 - 从所在分片开始按环扩展，参数与KD_TREE::nearestSearch相同
+     * 
+     * visitedNodes非空时输出各分片进入的节点数之和
+     */
+    void nearestSearch(const PointType& point, int kNearest, PointVector& nearestPoints,
+                       QVector<double>& pointDistance, double maxDist = std::numeric_limits<double>::infinity(),
+                       int* visitedNodes = nullptr) const
+    {
+        /**
+         * @brief K近邻搜索实现
+         * 
+         * 第r环是与所在分片切比雪夫距离为r的一圈网格，其中任一点到查询点的平面距离不小于查询点到内侧
+         * (2r-1)×(2r-1)网格块边界的距离，该下界达到当前第k近距离即停止。环内的分片按平面距离升序搜索，
+         * 传给分片的最大距离收紧到当前第k近距离。网格包围范围远大于分片数时改为对全部分片按距离排序
+         */
+        nearestPoints.clear();
+        pointDistance.clear();
+        if (visitedNodes) *visitedNodes = 0;
+        const SHARD_INDEX index = indexSnapshot();
+        if (kNearest <= 0 || index.shards.isEmpty()) return;
         
-        (*root)->working_flag = true;
-        pushDown(*root);
+        const double maxDist2 = maxDist * maxDist;
+        PointVector shardPoints;
+        QVector<double> shardDistance;
+        // 平面距离达到该界的分片不可能改进结果
+        auto reachable = [&](double cellDist2) {
+            if (cellDist2 > maxDist2) return false;
+            return pointDistance.size() < kNearest || cellDist2 < pointDistance.last();
+        };
+        auto searchShard = [&](const SHARD_CANDIDATE& candidate) {
+            if (!reachable(candidate.distance)) return;
+            const double shardMaxDist = pointDistance.size() < kNearest ? maxDist : qSqrt(pointDistance.last());
+            int visited = 0;
+            (*candidate.tree)->nearestSearch(point, kNearest, shardPoints, shardDistance, shardMaxDist,
+                                             visitedNodes ? &visited : nullptr);
+            if (visitedNodes) *visitedNodes += visited;
+            mergeNearest(kNearest, shardPoints, shardDistance, nearestPoints, pointDistance);
+        };
+        auto byDistance = [](const SHARD_CANDIDATE& a, const SHARD_CANDIDATE& b) { return a.distance < b.distance; };
         
-        if (samePoint((*root)->point, point) && !(*root)->point_deleted) {
-            (*root)->point_deleted = true;
-            (*root)->invalid_point_num += 1;
-            if ((*root)->invalid_point_num == (*root)->TreeSize) {
-                (*root)->tree_deleted = true;
+        const int cx = cellOf(point.x);
+        const int cy = cellOf(point.y);
+        const qint64 ringLimit = qMax(qMax(qint64(cx) - index.cellMin[0], qint64(index.cellMax[0]) - cx),
+                                      qMax(qint64(cy) - index.cellMin[1], qint64(index.cellMax[1]) - cy));
+        if ((2 * ringLimit + 1) * (2 * ringLimit + 1) > 4 * qint64(index.shards.size())) {
+            QVector<SHARD_CANDIDATE> candidates;
+            candidates.reserve(index.shards.size());
+            for (auto it = index.shards.constBegin(); it != index.shards.constEnd(); ++it) {
+                candidates.append({cellDistance(point, it.key()), &it.value()});
+            }
+            std::sort(candidates.begin(), candidates.end(), byDistance);
+            for (const SHARD_CANDIDATE& candidate : candidates) {
+                if (!reachable(candidate.distance)) break;
+                searchShard(candidate);
             }
             return;
         }
         
-        Operation_Logger_Type deleteLog;
-        deleteLog.op = DELETE_POINT;
-        deleteLog.point = point;
-        
-        // 根据分割轴决定搜索方向
-        bool goLeft = false;
-        if ((*root)->division_axis == 0) {
-            goLeft = (point.x < (*root)->point.x);
-        } else if ((*root)->division_axis == 1) {
-            goLeft = (point.y < (*root)->point.y);
-        } else {
-            goLeft = (point.z < (*root)->point.z);
+        QVarLengthArray<SHARD_CANDIDATE, 64> ring;
+        auto visitCell = [&](qint64 x, qint64 y) {
+            const quint64 key = shardKey(int(x), int(y));
+            auto it = index.shards.constFind(key);
+            if (it != index.shards.constEnd()) ring.append({cellDistance(point, key), &it.value()});
+        };
+        for (qint64 r = 0; r <= ringLimit; r++) {
+            if (r > 0) {
+                const double gap = qMax(0.0, qMin(qMin(point.x - (cx - r + 1) * m_shardSize, (cx + r) * m_shardSize - point.x),
+                                                  qMin(point.y - (cy - r + 1) * m_shardSize, (cy + r) * m_shardSize - point.y)));
+                if (!reachable(gap * gap)) break;
+            }
+            ring.clear();
+            if (r == 0) {
+                visitCell(cx, cy);
+            } else {
+                for (qint64 dx = -r; dx <= r; dx++) {
+                    visitCell(cx + dx, cy - r);
+                    visitCell(cx + dx, cy + r);
+                }
+                for (qint64 dy = -r + 1; dy <= r - 1; dy++) {
+                    visitCell(cx - r, cy + dy);
+                    visitCell(cx + r, cy + dy);
+                }
+            }
+            std::sort(ring.begin(), ring.end(), byDistance);
+            for (const SHARD_CANDIDATE& candidate : ring) searchShard(candidate);
+        }
+    }
+    
+    /**
+     * @brief 批量K近邻搜索 - 查询分块后在线程池中并行执行，结果与逐个调用nearestSearch相同
+     */
+    void nearestSearchBatch(const PointVector& queries, int kNearest, QVector<PointVector>& nearestPoints,
+                            QVector<QVector<double>>& pointDistances,
+                            double maxDist = std::numeric_limits<double>::infinity()) const
+    {
+        /**
+         * @brief 批量K近邻搜索实现
+         */
+        nearestPoints.resize(queries.size());
+        pointDistances.resize(queries.size());
+        const int chunks = (queries.size() + NEAREST_BATCH_CHUNK - 1) / NEAREST_BATCH_CHUNK;
+        runParallel(chunks, [&](int chunk) {
+            const int end = qMin(queries.size(), (chunk + 1) * NEAREST_BATCH_CHUNK);
+            for (int i = chunk * NEAREST_BATCH_CHUNK; i < end; i++) {
+                nearestSearch(queries[i], kNearest, nearestPoints[i], pointDistances[i], maxDist);
+            }
+        });
+    }
+    
+    /**
+     * @brief 获取森林大小 - 各分片大小之和
+     */
+    int size() const
+    {
+        const SHARD_INDEX index = indexSnapshot();
+        int treeSize = 0;
+        for (auto it = index.shards.constBegin(); it != index.shards.constEnd(); ++it) treeSize += it.value()->size();
+        return treeSize;
+    }
+    
+    /**
+     * @brief 获取有效节点数 - 各分片有效节点数之和
+     */
+    int validnum() const
+    {
+        const SHARD_INDEX index = indexSnapshot();
+        int valid = 0;
+        for (auto it = index.shards.constBegin(); it != index.shards.constEnd(); ++it) valid += it.value()->validnum();
+        return valid;
+    }
+    
+    /**
+     * @brief 获取点所在的分片，分片不存在时返回空指针
+     */
+    TreePtr shardAt(const PointType& point) const
+    {
+        return indexSnapshot().shards.value(shardKey(cellOf(point.x), cellOf(point.y)));
+    }
+    
+private:
+    /**
+     * @brief 分片批次 - 一个分片及路由到它的点、包围盒或搜索结果
+     */
+    struct SHARD_BATCH
+    {
+        quint64 key = 0;
+        TreePtr tree;
+        PointVector points;
+        QVector<BoxType> boxes;
+    };
+    
+    /**
+     * @brief 分片表 - 隐式共享，查询复制快照后即释放锁
+     */
+    struct SHARD_INDEX
+    {
+        QHash<quint64, TreePtr> shards;
+        int cellMin[2] = {std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};  ///< 已有分片的最小网格坐标
+        int cellMax[2] = {std::numeric_limits<int>::min(), std::numeric_limits<int>::min()};  ///< 已有分片的最大网格坐标
+    };
+    
+    /**
+     * @brief K近邻候选分片
+     */
+    struct SHARD_CANDIDATE
+    {
+        double distance;        ///< 查询点到分片网格的平面距离平方
+        const TreePtr* tree;    ///< 指向快照中的分片
+    };
+    
+    /**
+     * @brief 坐标所在的网格 - 先取下采样体素编号再整除，体素不会跨越网格边界
+     */
+    int cellOf(double coordinate) const
+    {
+        if (m_cellVoxels <= 0) return qFloor(coordinate / m_shardSize);
+        const int voxel = qFloor(coordinate / m_boxLength);
+        return voxel >= 0 ? voxel / m_cellVoxels : -((-voxel - 1) / m_cellVoxels) - 1;
+    }
+    
+    static quint64 shardKey(int cellX, int cellY)
+    {
+        return (quint64(quint32(cellX)) << 32) | quint32(cellY);
+    }
+    
+    /**
+     * @brief 查询点到分片网格单元的平面距离平方，是分片内任意点到查询点距离平方的下界
+     */
+    double cellDistance(const PointType& point, quint64 key) const
+    {
+        const double minX = qint32(quint32(key >> 32)) * m_shardSize;
+        const double minY = qint32(quint32(key)) * m_shardSize;
+        const double dx = qMax(0.0, qMax(minX - point.x, point.x - (minX + m_shardSize)));
+        const double dy = qMax(0.0, qMax(minY - point.y, point.y - (minY + m_shardSize)));
+        return dx * dx + dy * dy;
+    }
+    
+    SHARD_INDEX indexSnapshot() const
+    {
+        ReadLocker indexLocker(&m_indexLock);
+        return m_index;
+    }
+    
+    TreePtr createShard() const
+    {
+        return TreePtr(new TreeType(m_deleteParam, m_balanceParam, m_boxLength));
+    }
+    
+    static void insertShard(SHARD_INDEX& index, quint64 key, const TreePtr& tree)
+    {
+        const int cell[2] = {qint32(quint32(key >> 32)), qint32(quint32(key))};
+        index.shards.insert(key, tree);
+        for (int i = 0; i < 2; i++) {
+            index.cellMin[i] = qMin(index.cellMin[i], cell[i]);
+            index.cellMax[i] = qMax(index.cellMax[i], cell[i]);
         }
-        
-        if (goLeft) {
-            if ((m_rebuildPtr == nullptr) || (*root)->left_son_ptr != *m_rebuildPtr) {
-                deleteByPoint(&(*root)->left_son_ptr, point, allowRebuild);
-            } else {
-                QMutexLocker workingLocker(&m_workingFlagMutex);
-                deleteByPoint(&(*root)->left_son_ptr, point, false);
-                if (m_rebuildFlag.loadRelaxed()) {
-                    QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                    m_rebuildLogger.push(deleteLog);
-                }
-            }
-        } else {
-            if ((m_rebuildPtr == nullptr) || (*root)->right_son_ptr != *m_rebuildPtr) {
-                deleteByPoint(&(*root)->right_son_ptr, point, allowRebuild);
-            } else {
-                QMutexLocker workingLocker(&m_workingFlagMutex);
-                deleteByPoint(&(*root)->right_son_ptr, point, false);
-                if (m_rebuildFlag.loadRelaxed()) {
-                    QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                    m_rebuildLogger.push(deleteLog);
-                }
+    }
+    
+    /**
+     * @brief 按分片分组点，组内保持输入顺序；同一下采样体素的点总在同一组
+     */
+    void groupPoints(const PointVector& points, QVector<SHARD_BATCH>& batches) const
+    {
+        /**
+         * @brief 按分片分组点实现
+         */
+        batches.clear();
+        QHash<quint64, int> batchOfKey;
+        for (const PointType& point : points) {
+            const quint64 key = shardKey(cellOf(point.x), cellOf(point.y));
+            int& slot = batchOfKey[key];
+            if (slot == 0) {
+                batches.append(SHARD_BATCH());
+                batches.last().key = key;
+                slot = batches.size();
             }
-        }
-        
-        update(*root);
-        
-        if (m_rebuildPtr != nullptr && *m_rebuildPtr == *root && 
-            (*root)->TreeSize < MULTI_THREAD_REBUILD_POINT_NUM) {
-            m_rebuildPtr = nullptr;
-        }
-        
-        bool needRebuild = allowRebuild && criterionCheck(*root);
-        if (needRebuild) {
-            rebuild(root);
-        }
-        
-        if ((*root) != nullptr) {
-            (*root)->working_flag = false;
+            batches[slot - 1].points.append(point);
         }
     }
-
-    int deleteByRange(KD_TREE_NODE** root, const BoxPointType& boxpoint, bool allowRebuild, bool isDownsample) {
+    
+    /**
+     * @brief 为每个批次取得分片，缺少的分片在写锁下创建
+     */
+    void acquireShards(QVector<SHARD_BATCH>& batches)
+    {
         /**
-         * @brief 按包围盒删除实现 - 删除指定范围内的点
+         * @brief 取得分片实现 - 先在读锁下查找，仍有缺失时再加写锁补建
          */
-        if ((*root) == nullptr || (*root)->tree_deleted) return 0;
-        
-        (*root)->working_flag = true;
-        pushDown(*root);
-        
-        int tmpCounter = 0;
-        
-        // 检查包围盒是否与节点范围相交
-        if (boxpoint.vertex_max[0] <= (*root)->node_range_x[0] || boxpoint.vertex_min[0] > (*root)->node_range_x[1]) return 0;
-        if (boxpoint.vertex_max[1] <= (*root)->node_range_y[0] || boxpoint.vertex_min[1] > (*root)->node_range_y[1]) return 0;
-        if (boxpoint.vertex_max[2] <= (*root)->node_range_z[0] || boxpoint.vertex_min[2] > (*root)->node_range_z[1]) return 0;
-        
-        // 如果包围盒完全包含节点范围，删除整个子树
-        if (boxpoint.vertex_min[0] <= (*root)->node_range_x[0] && boxpoint.vertex_max[0] > (*root)->node_range_x[1] && 
-            boxpoint.vertex_min[1] <= (*root)->node_range_y[0] && boxpoint.vertex_max[1] > (*root)->node_range_y[1] && 
-            boxpoint.vertex_min[2] <= (*root)->node_range_z[0] && boxpoint.vertex_max[2] > (*root)->node_range_z[1]) {
-            
-            (*root)->tree_deleted = true;
-            (*root)->point_deleted = true;
-            (*root)->need_push_down_to_left = true;
-            (*root)->need_push_down_to_right = true;
-            tmpCounter = (*root)->TreeSize - (*root)->invalid_point_num;
-            (*root)->invalid_point_num = (*root)->TreeSize;
-            
-            if (isDownsample) {
-                (*root)->tree_downsample_deleted = true;
-                (*root)->point_downsample_deleted = true;
-                (*root)->down_del_num = (*root)->TreeSize;
+        bool missing = false;
+        {
+            ReadLocker indexLocker(&m_indexLock);
+            for (SHARD_BATCH& batch : batches) {
+                batch.tree = m_index.shards.value(batch.key);
+                missing = missing || !batch.tree;
             }
-            return tmpCounter;
-        }
-        
-        // 检查当前节点的点是否在包围盒内
-        if (!(*root)->point_deleted && 
-            boxpoint.vertex_min[0] <= (*root)->point.x && boxpoint.vertex_max[0] > (*root)->point.x && 
-            boxpoint.vertex_min[1] <= (*root)->point.y && boxpoint.vertex_max[1] > (*root)->point.y && 
-            boxpoint.vertex_min[2] <= (*root)->point.z && boxpoint.vertex_max[2] > (*root)->point.z) {
-            
-            (*root)->point_deleted = true;
-            tmpCounter += 1;
-            if (isDownsample) (*root)->point_downsample_deleted = true;
         }
-        
-        Operation_Logger_Type deleteBoxLog;
-        if (isDownsample) {
-            deleteBoxLog.op = DOWNSAMPLE_DELETE;
-        } else {
-            deleteBoxLog.op = DELETE_BOX;
+        if (!missing) return;
+        WriteLocker indexLocker(&m_indexLock);
+        for (SHARD_BATCH& batch : batches) {
+            if (batch.tree) continue;
+            batch.tree = m_index.shards.value(batch.key);
+            if (batch.tree) continue;
+            batch.tree = createShard();
+            insertShard(m_index, batch.key, batch.tree);
         }
-        deleteBoxLog.boxpoint = boxpoint;
-        
-        // 递归处理左子树
-        if ((m_rebuildPtr == nullptr) || (*root)->left_son_ptr != *m_rebuildPtr) {
-            tmpCounter += deleteByRange(&((*root)->left_son_ptr), boxpoint, allowRebuild, isDownsample);
-        } else {
-            QMutexLocker workingLocker(&m_workingFlagMutex);
-            tmpCounter += deleteByRange(&((*root)->left_son_ptr), boxpoint, false, isDownsample);
-            if (m_rebuildFlag.loadRelaxed()) {
-                QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                m_rebuildLogger.push(deleteBoxLog);
+    }
+    
+    /**
+     * @brief 取与平面矩形相交的分片，按分片键排序
+     * 
+     * 矩形先裁剪到已有分片的网格范围；裁剪后的网格数多于分片数时遍历分片表，否则逐个网格查找
+     */
+    void collectShards(const SHARD_INDEX& index, double minX, double minY, double maxX, double maxY,
+                       QVector<SHARD_BATCH>& shards) const
+    {
+        /**
+         * @brief 取相交分片实现
+         */
+        shards.clear();
+        if (index.shards.isEmpty()) return;
+        const int x0 = qMax(cellOf(minX), index.cellMin[0]);
+        const int x1 = qMin(cellOf(maxX), index.cellMax[0]);
+        const int y0 = qMax(cellOf(minY), index.cellMin[1]);
+        const int y1 = qMin(cellOf(maxY), index.cellMax[1]);
+        if (x0 > x1 || y0 > y1) return;
+        auto append = [&](quint64 key, const TreePtr& tree) {
+            shards.append(SHARD_BATCH());
+            shards.last().key = key;
+            shards.last().tree = tree;
+        };
+        if ((qint64(x1) - x0 + 1) * (qint64(y1) - y0 + 1) > index.shards.size()) {
+            for (auto it = index.shards.constBegin(); it != index.shards.constEnd(); ++it) {
+                const int cellX = qint32(quint32(it.key() >> 32));
+                const int cellY = qint32(quint32(it.key()));
+                if (cellX >= x0 && cellX <= x1 && cellY >= y0 && cellY <= y1) append(it.key(), it.value());
             }
-        }
-        
-        // 递归处理右子树
-        if ((m_rebuildPtr == nullptr) || (*root)->right_son_ptr != *m_rebuildPtr) {
-            tmpCounter += deleteByRange(&((*root)->right_son_ptr), boxpoint, allowRebuild, isDownsample);
         } else {
-            QMutexLocker workingLocker(&m_workingFlagMutex);
-            tmpCounter += deleteByRange(&((*root)->right_son_ptr), boxpoint, false, isDownsample);
-            if (m_rebuildFlag.loadRelaxed()) {
-                QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                m_rebuildLogger.push(deleteBoxLog);
+            for (qint64 x = x0; x <= x1; x++) {
+                for (qint64 y = y0; y <= y1; y++) {
+                    const quint64 key = shardKey(int(x), int(y));
+                    auto it = index.shards.constFind(key);
+                    if (it != index.shards.constEnd()) append(key, it.value());
+                }
             }
         }
-        
-        update(*root);
-        
-        if (m_rebuildPtr != nullptr && *m_rebuildPtr == *root && 
-            (*root)->TreeSize < MULTI_THREAD_REBUILD_POINT_NUM) {
-            m_rebuildPtr = nullptr;
-        }
-        
-        bool needRebuild = allowRebuild && criterionCheck(*root);
-        if (needRebuild) {
-            rebuild(root);
+        std::sort(shards.begin(), shards.end(), [](const SHARD_BATCH& a, const SHARD_BATCH& b) { return a.key < b.key; });
+    }
+    
+    /**
+     * @brief 按分片顺序拼接各分片的搜索结果
+     */
+    static void concatenate(QVector<SHARD_BATCH>& shards, PointVector& storage)
+    {
+        storage.clear();
+        if (shards.size() == 1) {
+            storage.swap(shards[0].points);
+            return;
         }
-        
-        if ((*root) != nullptr) {
-            (*root)->working_flag = false;
+        int total = 0;
+        for (const SHARD_BATCH& shard : shards) total += shard.points.size();
+        storage.reserve(total);
+        for (const SHARD_BATCH& shard : shards) storage.append(shard.points);
+    }
+    
+    /**
+     * @brief 把一个分片的升序近邻结果并入当前结果，至多保留k个，距离相同时保留已有结果
+     */
+    static void mergeNearest(int kNearest, const PointVector& shardPoints, const QVector<double>& shardDistance,
+                             PointVector& nearestPoints, QVector<double>& pointDistance)
+    {
+        /**
+         * @brief 合并近邻结果实现
+         */
+        if (shardPoints.isEmpty()) return;
+        PointVector mergedPoints;
+        QVector<double> mergedDistance;
+        mergedPoints.reserve(kNearest);
+        mergedDistance.reserve(kNearest);
+        int i = 0;
+        int j = 0;
+        while (mergedPoints.size() < kNearest && (i < nearestPoints.size() || j < shardPoints.size())) {
+            if (j >= shardPoints.size() || (i < nearestPoints.size() && pointDistance[i] <= shardDistance[j])) {
+                mergedPoints.append(nearestPoints[i]);
+                mergedDistance.append(pointDistance[i]);
+                i++;
+            } else {
+                mergedPoints.append(shardPoints[j]);
+                mergedDistance.append(shardDistance[j]);
+                j++;
+            }
         }
-        
-        return tmpCounter;
+        nearestPoints.swap(mergedPoints);
+        pointDistance.swap(mergedDistance);
     }
-
-    void addByRange(KD_TREE_NODE** root, const BoxPointType& boxpoint, bool allowRebuild) {
+    
+    /**
+     * @brief 并行执行count个任务 - 调用线程也参与，任务编号由原子计数器分发
+     */
+    template<typename Task>
+    void runParallel(int count, Task task) const
+    {
         /**
-         * @brief 按包围盒添加实现 - 恢复指定范围内的点
+         * @brief 并行执行实现 - 单线程策略或只有一个任务时在调用线程内依次执行
          */
-        if ((*root) == nullptr) return;
-        
-        (*root)->working_flag = true;
-        pushDown(*root);
-        
-        // 检查包围盒是否与节点范围相交
-        if (boxpoint.vertex_max[0] <= (*root)->node_range_x[0] || boxpoint.vertex_min[0] > (*root)->node_range_x[1]) return;
-        if (boxpoint.vertex_max[1] <= (*root)->node_range_y[0] || boxpoint.vertex_min[1] > (*root)->node_range_y[1]) return;
-        if (boxpoint.vertex_max[2] <= (*root)->node_range_z[0] || boxpoint.vertex_min[2] > (*root)->node_range_z[1]) return;
-        
-        // 如果包围盒完全包含节点范围，恢复整个子树
-        if (boxpoint.vertex_min[0] <= (*root)->node_range_x[0] && boxpoint.vertex_max[0] > (*root)->node_range_x[1] && 
-            boxpoint.vertex_min[1] <= (*root)->node_range_y[0] && boxpoint.vertex_max[1] > (*root)->node_range_y[1] && 
-            boxpoint.vertex_min[2] <= (*root)->node_range_z[0] && boxpoint.vertex_max[2] > (*root)->node_range_z[1]) {
-            
-            (*root)->tree_deleted = false || (*root)->tree_downsample_deleted;
-            (*root)->point_deleted = false || (*root)->point_downsample_deleted;
-            (*root)->need_push_down_to_left = true;
-            (*root)->need_push_down_to_right = true;
-            (*root)->invalid_point_num = (*root)->down_del_num;
+        const int workers = qMin(count, m_threadCount);
+        if (!ThreadPolicy::kMultiThread || workers <= 1) {
+            for (int i = 0; i < count; i++) task(i);
             return;
         }
-        
-        // 检查当前节点的点是否在包围盒内
-        if (boxpoint.vertex_min[0] <= (*root)->point.x && boxpoint.vertex_max[0] > (*root)->point.x && 
-            boxpoint.vertex_min[1] <= (*root)->point.y && boxpoint.vertex_max[1] > (*root)->point.y && 
-            boxpoint.vertex_min[2] <= (*root)->point.z && boxpoint.vertex_max[2] > (*root)->point.z) {
-            
-            (*root)->point_deleted = (*root)->point_downsample_deleted;
+        QAtomicInt next(0);
+        QSemaphore finished;
+        auto work = [&]() {
+            for (int i = next.fetchAndAddRelaxed(1); i < count; i = next.fetchAndAddRelaxed(1)) task(i);
+        };
+        for (int i = 1; i < workers; i++) {
+            m_threadPool.start([&]() {
+                work();
+                finished.release();
+            });
         }
-        
-        Operation_Logger_Type addBoxLog;
-        addBoxLog.op = ADD_BOX;
-        addBoxLog.boxpoint = boxpoint;
-        
-        // 递归处理左子树
-        if ((m_rebuildPtr == nullptr) || (*root)->left_son_ptr != *m_rebuildPtr) {
-            addByRange(&((*root)->left_son_ptr), boxpoint, allowRebuild);
-        } else {
-            QMutexLocker workingLocker(&m_workingFlagMutex);
-            addByRange(&((*root)->left_son_ptr), boxpoint, false);
-            if (m_rebuildFlag.loadRelaxed()) {
-                QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                m_rebuildLogger.push(addBoxLog);
-            }
+        work();
+        finished.acquire(workers - 1);
+    }
+    
+    int m_cellVoxels;           ///< 每个网格单元沿一轴的下采样体素数，下采样边长不大于0时为0
+    double m_shardSize;         ///< 分片网格边长
+    double m_deleteParam;       ///< 分片删除判据参数
+    double m_balanceParam;      ///< 分片平衡判据参数
+    double m_boxLength;         ///< 分片下采样边长
+    int m_threadCount = 1;      ///< 并行线程数，包括调用线程
+    SHARD_INDEX m_index;        ///< 分片表
+    mutable typename TreeType::ReadWriteLock m_indexLock;  ///< 分片表读写锁
+    typename TreeType::ReadWriteLock m_buildLock;          ///< 构建锁，build持写模式，其他写方法持读模式
+    mutable QThreadPool m_threadPool;   ///< 分片并行处理线程池
+};
+
+/**
+ * @brief 异步K-D树外观 - 修改在树专属的写线程上排队执行，查询在读线程池上执行，均返回QFuture
+ *
+ * 传感器回调只负责把点集放入写队列，插入、删除以及随之触发的重建都在写线程上完成，回调线程不等待树的维护。
+ * 写队列按待处理的点数（包围盒删除按包围盒数）计量，超过上限时按OverflowPolicy拒绝或等待：
+ * RejectWhenFull下新的批次立即得到已取消的future并计入rejectedBatches()，回调线程从不阻塞；
+ * BlockWhenFull下提交线程等到队列降到上限以下。队列为空时单个超限批次总会被接受。
+ * 修改的future完成时其结果已对之后的查询可见；写操作按提交顺序执行。
+ * 查询future在读线程池上调用树的const查询方法，与写线程按KD_TREE的单写多读约定并发；
+ * 也可以直接通过tree()同步查询或取快照
+ * @tparam PointType 点类型
+ */
+template<typename PointType>
+class KD_TREE_ASYNC
+{
+public:
+    using TreeType = KD_TREE<PointType, MultiThreaded>;    ///< 内部K-D树类型
+    using TreePtr = typename TreeType::Ptr;                 ///< 树智能指针类型
+    using PointVector = typename TreeType::PointVector;     ///< 点向量类型
+    using BoxType = typename TreeType::BoxType;             ///< 包围盒类型
+    
+    static constexpr int DEFAULT_MAX_PENDING_POINTS = 1000000;  ///< 默认写队列上限（点数）
+    
+    /**
+     * @brief 写队列已满时的处理方式
+     */
+    enum OverflowPolicy
+    {
+        RejectWhenFull,     ///< 立即返回已取消的future，提交线程不阻塞
+        BlockWhenFull       ///< 提交线程等待队列降到上限以下
+    };
+    
+    /**
+     * @brief K近邻查询结果
+     */
+    struct NEAREST_RESULT
+    {
+        PointVector points;         ///< 近邻点，按距离升序
+        QVector<double> distances;  ///< 对应的距离平方
+    };
+    
+    /**
+     * @brief 构造函数 - 启动写线程
+     * @param tree 被管理的树，为空时新建一棵默认参数的树
+     * @param maxPendingPoints 写队列上限（点数）
+     * @param overflowPolicy 写队列已满时的处理方式
+     */
+    explicit KD_TREE_ASYNC(TreePtr tree = TreePtr(), int maxPendingPoints = DEFAULT_MAX_PENDING_POINTS,
+                           OverflowPolicy overflowPolicy = RejectWhenFull)
+        : m_tree(tree ? tree : TreePtr(new TreeType())), m_maxPendingPoints(qMax(1, maxPendingPoints)),
+          m_overflowPolicy(overflowPolicy), m_rejectedBatches(0)
+    {
+        m_writerThread.reset(QThread::create([this]() { this->writerLoop(); }));
+        m_writerThread->start();
+    }
+    
+    /**
+     * @brief 析构函数 - 执行完已排队的修改后停止写线程，等待读线程池中的查询结束
+     */
+    ~KD_TREE_ASYNC()
+    {
+        {
+            QMutexLocker locker(&m_queueMutex);
+            m_stopping = true;
+            m_queueNotEmpty.wakeAll();
+            m_queueChanged.wakeAll();
         }
-        
-        // 递归处理右子树
-        if ((m_rebuildPtr == nullptr) || (*root)->right_son_ptr != *m_rebuildPtr) {
-            addByRange(&((*root)->right_son_ptr), boxpoint, allowRebuild);
+        m_writerThread->wait();
+        m_readerPool.waitForDone();
+    }
+    
+    /**
+     * @brief 异步构建树，丢弃已有的点
+     */
+    QFuture<void> build(const PointVector& pointCloud)
+    {
+        TreePtr tree = m_tree;
+        return enqueue<void>(pointCloud.size(), [tree, pointCloud]() { tree->build(pointCloud); });
+    }
+    
+    /**
+     * @brief 异步添加点集合
+     * @return 结果与KD_TREE::addPoints相同；批次被拒绝时future为已取消状态
+     */
+    QFuture<int> addPoints(const PointVector& pointToAdd, bool downsampleOn)
+    {
+        TreePtr tree = m_tree;
+        return enqueue<int>(pointToAdd.size(), [tree, pointToAdd, downsampleOn]() {
+            PointVector points = pointToAdd;
+            return tree->addPoints(points, downsampleOn);
+        });
+    }
+    
+    /**
+     * @brief 异步删除点集合
+     */
+    QFuture<void> deletePoints(const PointVector& pointToDel)
+    {
+        TreePtr tree = m_tree;
+        return enqueue<void>(pointToDel.size(), [tree, pointToDel]() {
+            PointVector points = pointToDel;
+            tree->deletePoints(points);
+        });
+    }
+    
+    /**
+     * @brief 异步删除包围盒内的点
+     * @return 删除的点数
+     */
+    QFuture<int> deletePointBoxes(const QVector<BoxType>& boxPoints)
+    {
+        TreePtr tree = m_tree;
+        return enqueue<int>(boxPoints.size(), [tree, boxPoints]() {
+            QVector<BoxType> boxes = boxPoints;
+            return tree->deletePointBoxes(boxes);
+        });
+    }
+    
+    /**
+     * @brief 在读线程池上做K近邻搜索
+     */
+    QFuture<NEAREST_RESULT> nearestSearch(const PointType& point, int kNearest,
+                                          double maxDist = std::numeric_limits<double>::infinity()) const
+    {
+        TreePtr tree = m_tree;
+        return runOnReader<NEAREST_RESULT>([tree, point, kNearest, maxDist]() {
+            NEAREST_RESULT result;
+            tree->nearestSearch(point, kNearest, result.points, result.distances, maxDist);
+            return result;
+        });
+    }
+    
+    /**
+     * @brief 在读线程池上做半径搜索
+     */
+    QFuture<PointVector> radiusSearch(const PointType& point, double radius) const
+    {
+        TreePtr tree = m_tree;
+        return runOnReader<PointVector>([tree, point, radius]() {
+            PointVector storage;
+            tree->radiusSearch(point, radius, storage);
+            return storage;
+        });
+    }
+    
+    /**
+     * @brief 在读线程池上做包围盒搜索
+     */
+    QFuture<PointVector> boxSearch(const BoxType& boxOfPoint) const
+    {
+        TreePtr tree = m_tree;
+        return runOnReader<PointVector>([tree, boxOfPoint]() {
+            PointVector storage;
+            tree->boxSearch(boxOfPoint, storage);
+            return storage;
+        });
+    }
+    
+    /**
+     * @brief 等待写队列清空且写线程空闲
+     */
+    void waitForIdle()
+    {
+        QMutexLocker locker(&m_queueMutex);
+        while (m_pendingPoints > 0) m_queueChanged.wait(&m_queueMutex);
+    }
+    
+    /**
+     * @brief 设置读线程池的线程数
+     */
+    void setReaderThreadCount(int threadCount)
+    {
+        m_readerPool.setMaxThreadCount(qMax(1, threadCount));
+    }
+    
+    /**
+     * @brief 写队列中尚未完成的点数，包括写线程正在处理的批次
+     */
+    int pendingPoints() const
+    {
+        QMutexLocker locker(&m_queueMutex);
+        return m_pendingPoints;
+    }
+    
+    /**
+     * @brief 因写队列已满被拒绝的批次数
+     */
+    int rejectedBatches() const
+    {
+        return m_rejectedBatches.loadRelaxed();
+    }
+    
+    /**
+     * @brief 访问被管理的树，可直接做同步查询或取快照；修改应通过本类提交
+     */
+    TreePtr tree() const
+    {
+        return m_tree;
+    }
+    
+private:
+    /**
+     * @brief 写任务 - 计量权重与执行体，执行体负责完成对应的promise
+     */
+    struct WRITE_TASK
+    {
+        int weight = 0;
+        std::function<void()> run;
+    };
+    
+    /**
+     * @brief 执行work并把返回值写入promise
+     */
+    template<typename Result, typename Work>
+    static void fulfil(QPromise<Result>& promise, Work& work)
+    {
+        promise.start();
+        if constexpr (std::is_void_v<Result>) {
+            work();
         } else {
-            QMutexLocker workingLocker(&m_workingFlagMutex);
-            addByRange(&((*root)->right_son_ptr), boxpoint, false);
-            if (m_rebuildFlag.loadRelaxed()) {
-                QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                m_rebuildLogger.push(addBoxLog);
+            promise.addResult(work());
+        }
+        promise.finish();
+    }
+    
+    /**
+     * @brief 把修改放入写队列
+     * @param weight 计入队列上限的权重
+     */
+    template<typename Result, typename Work>
+    QFuture<Result> enqueue(int weight, Work work)
+    {
+        /**
+         * @brief 放入写队列实现 - 队列非空且加入后超过上限时按策略拒绝或等待；开始析构后一律拒绝，
+         * 写线程可能已经退出，排队的修改不会再执行
+         */
+        weight = qMax(1, weight);
+        QSharedPointer<QPromise<Result>> promise(new QPromise<Result>());
+        QFuture<Result> future = promise->future();
+        QMutexLocker locker(&m_queueMutex);
+        while (m_stopping || (m_pendingPoints > 0 && m_pendingPoints + weight > m_maxPendingPoints)) {
+            if (m_overflowPolicy == RejectWhenFull || m_stopping) {
+                locker.unlock();
+                m_rejectedBatches.fetchAndAddRelaxed(1);
+                promise->start();
+                future.cancel();
+                promise->finish();
+                return future;
             }
+            m_queueChanged.wait(&m_queueMutex);
+        }
+        WRITE_TASK task;
+        task.weight = weight;
+        task.run = [promise, work]() mutable { fulfil(*promise, work); };
+        m_writeQueue.enqueue(task);
+        m_pendingPoints += weight;
+        m_queueNotEmpty.wakeOne();
+        return future;
+    }
+    
+    /**
+     * @brief 在读线程池上执行查询
+     */
+    template<typename Result, typename Work>
+    QFuture<Result> runOnReader(Work work) const
+    {
+        QSharedPointer<QPromise<Result>> promise(new QPromise<Result>());
+        QFuture<Result> future = promise->future();
+        m_readerPool.start([promise, work]() mutable { fulfil(*promise, work); });
+        return future;
+    }
+    
+    /**
+     * @brief 写线程主循环 - 按提交顺序执行修改，停止时先执行完队列中剩余的修改
+     */
+    void writerLoop()
+    {
+        QMutexLocker locker(&m_queueMutex);
+        while (true) {
+            while (m_writeQueue.isEmpty() && !m_stopping) m_queueNotEmpty.wait(&m_queueMutex);
+            if (m_writeQueue.isEmpty()) return;
+            WRITE_TASK task = m_writeQueue.dequeue();
+            locker.unlock();
+            task.run();
+            task.run = nullptr;
+            locker.relock();
+            m_pendingPoints -= task.weight;
+            m_queueChanged.wakeAll();
         }
+    }
+    
+    TreePtr m_tree;                         ///< 被管理的树
+    const int m_maxPendingPoints;           ///< 写队列上限（点数）
+    const OverflowPolicy m_overflowPolicy;  ///< 写队列已满时的处理方式
+    mutable QMutex m_queueMutex;            ///< 写队列互斥锁
+    QWaitCondition m_queueNotEmpty;         ///< 写队列非空条件
+    QWaitCondition m_queueChanged;          ///< 写任务完成条件，唤醒等待空间和等待空闲的线程
+    QQueue<WRITE_TASK> m_writeQueue;        ///< 写队列
+    int m_pendingPoints = 0;                ///< 写队列中尚未完成的点数
+    bool m_stopping = false;                ///< 是否正在停止写线程
+    QAtomicInt m_rejectedBatches;           ///< 被拒绝的批次数
+    QScopedPointer<QThread> m_writerThread; ///< 写线程
+    mutable QThreadPool m_readerPool;       ///< 读线程池
+};
+
+/**
+ * @brief 帧插入流水线 - 坐标变换、体素滤波和插入三个阶段各占一个线程，阶段之间以有界队列衔接
+ *
+ * 插入线程处理第N帧时，滤波线程和变换线程可以同时处理第N+1、N+2帧。
+ * 体素滤波与树的下采样使用同一网格和同一判据（每个体素保留离体素中心最近的点，距离相同时保留后到的点），
+ * 树开启压缩叶块时先按树的量化网格对齐坐标再滤波，与树对输入点的处理一致。
+ * 体素边长等于树的下采样边长时插入结果与逐帧调用addPoints(points, true)相同，只是插入阶段要处理的点更少；
+ * 例外是树中同一体素已有多个点到体素中心的距离恰好相等，树保留检索先遇到的点，两种流程保留的点可能不同，
+ * 量化分辨率较粗的压缩叶块上偶有发生。
+ * 阶段之间的队列已满时上游阶段等待；输入队列已满时按OverflowPolicy丢弃新帧或让提交线程等待。
+ * 每个阶段统计处理的帧数、输入输出点数和耗时，另统计从提交到插入完成的端到端延迟
+ * @tparam PointType 点类型
+ */
+template<typename PointType>
+class KD_TREE_INGEST
+{
+public:
+    using TreeType = KD_TREE<PointType, MultiThreaded>;    ///< 内部K-D树类型
+    using TreePtr = typename TreeType::Ptr;                 ///< 树智能指针类型
+    using PointVector = typename TreeType::PointVector;     ///< 点向量类型
+    using Scalar = typename TreeType::Scalar;               ///< 坐标标量类型
+    using BoxType = typename TreeType::BoxType;             ///< 包围盒类型
+    
+    static constexpr int DEFAULT_QUEUE_CAPACITY = 2;        ///< 默认每个队列容纳的帧数
+    static constexpr int STAGE_COUNT = 3;                   ///< 阶段数
+    
+    /**
+     * @brief 输入队列已满时的处理方式
+     */
+    enum OverflowPolicy
+    {
+        RejectWhenFull,     ///< 丢弃新帧，提交线程不阻塞
+        BlockWhenFull       ///< 提交线程等待输入队列有空位
+    };
+    
+    /**
+     * @brief 流水线阶段
+     */
+    enum Stage
+    {
+        TransformStage,     ///< 传感器坐标系到世界坐标系
+        FilterStage,        ///< 体素滤波
+        InsertStage         ///< 插入树
+    };
+    
+    /**
+     * @brief 刚体位姿 - 世界坐标 = rotation * 传感器坐标 + translation
+     */
+    struct POSE
+    {
+        double rotation[3][3] = {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}};   ///< 旋转矩阵，行优先
+        double translation[3] = {0.0, 0.0, 0.0};                                         ///< 平移
         
-        update(*root);
-        
-        if (m_rebuildPtr != nullptr && *m_rebuildPtr == *root && 
-            (*root)->TreeSize < MULTI_THREAD_REBUILD_POINT_NUM) {
-            m_rebuildPtr = nullptr;
+        /**
+         * @brief 由单位四元数和平移构造位姿
+         */
+        static POSE fromQuaternion(double w, double x, double y, double z, const Vector3D& position)
+        {
+            POSE pose;
+            pose.rotation[0][0] = 1.0 - 2.0 * (y * y + z * z);
+            pose.rotation[0][1] = 2.0 * (x * y - w * z);
+            pose.rotation[0][2] = 2.0 * (x * z + w * y);
+            pose.rotation[1][0] = 2.0 * (x * y + w * z);
+            pose.rotation[1][1] = 1.0 - 2.0 * (x * x + z * z);
+            pose.rotation[1][2] = 2.0 * (y * z - w * x);
+            pose.rotation[2][0] = 2.0 * (x * z - w * y);
+            pose.rotation[2][1] = 2.0 * (y * z + w * x);
+            pose.rotation[2][2] = 1.0 - 2.0 * (x * x + y * y);
+            pose.translation[0] = position.x();
+            pose.translation[1] = position.y();
+            pose.translation[2] = position.z();
+            return pose;
         }
         
-        bool needRebuild = allowRebuild && criterionCheck(*root);
-        if (needRebuild) {
-            rebuild(root);
+        /**
+         * @brief 变换一个点，附加数据保持不变
+         */
+        PointType apply(const PointType& point) const
+        {
+            PointType result = point;
+            const double px = point.x, py = point.y, pz = point.z;
+            result.x = rotation[0][0] * px + rotation[0][1] * py + rotation[0][2] * pz + translation[0];
+            result.y = rotation[1][0] * px + rotation[1][1] * py + rotation[1][2] * pz + translation[1];
+            result.z = rotation[2][0] * px + rotation[2][1] * py + rotation[2][2] * pz + translation[2];
+            return result;
         }
+    };
+    
+    /**
+     * @brief 单个阶段的统计
+     */
+    struct STAGE_STATS
+    {
+        qint64 frames = 0;      ///< 处理的帧数
+        qint64 pointsIn = 0;    ///< 输入点数
+        qint64 pointsOut = 0;   ///< 输出点数，插入阶段为addPoints的返回值之和
+        double busyMs = 0.0;    ///< 处理耗时之和，不含在队列中等待的时间
+        double maxMs = 0.0;     ///< 单帧最长处理耗时
         
-        if ((*root) != nullptr) {
-            (*root)->working_flag = false;
-        }
-    }
-
-    void rebuild(KD_TREE_NODE** root) {
         /**
-         * @brief 重建子树实现 - 重新平衡树结构以提高性能
+         * @brief 单帧平均处理耗时
          */
-        if (!root || !*root) return;
-        
-        // 如果子树太小，不需要重建
-        if ((*root)->TreeSize < Minimal_Unbalanced_Tree_Size) return;
-        
-        // 收集所有有效点
-        PointVector storage;
-        flatten(*root, storage, NOT_RECORD);
+        double meanMs() const { return frames > 0 ? busyMs / frames : 0.0; }
         
-        // 删除原有节点
-        deleteTreeNodes(root);
+        /**
+         * @brief 阶段吞吐量 - 每秒处理耗时内处理的输入点数，即该阶段单独运行时的处理能力
+         */
+        double pointsPerSecond() const { return busyMs > 0.0 ? pointsIn * 1000.0 / busyMs : 0.0; }
+    };
+    
+    /**
+     * @brief 流水线统计
+     */
+    struct STATS
+    {
+        STAGE_STATS stages[STAGE_COUNT];    ///< 按Stage索引的各阶段统计
+        qint64 framesSubmitted = 0;         ///< 被接受的帧数
+        qint64 framesDropped = 0;           ///< 输入队列已满被丢弃的帧数
+        qint64 framesInserted = 0;          ///< 插入完成的帧数
+        double meanLatencyMs = 0.0;         ///< 从提交到插入完成的平均延迟
+        double maxLatencyMs = 0.0;          ///< 从提交到插入完成的最长延迟
+        double elapsedMs = 0.0;             ///< 统计区间长度
         
-        // 重新构建平衡的树
-        if (!storage.empty()) {
-            buildTree(root, 0, storage.size() - 1, storage);
-            if (*root) {
-                update(*root);
-            }
+        /**
+         * @brief 整条流水线的帧吞吐量
+         */
+        double framesPerSecond() const { return elapsedMs > 0.0 ? framesInserted * 1000.0 / elapsedMs : 0.0; }
+    };
+    
+    /**
+     * @brief 构造函数 - 启动三个阶段线程
+     * @param tree 被写入的树，为空时新建一棵默认参数的树
+     * @param voxelSize 体素滤波边长，应与树的下采样边长相同；不大于0时不滤波，插入也不下采样
+     * @param queueCapacity 每个队列容纳的帧数
+     * @param overflowPolicy 输入队列已满时的处理方式
+     */
+    explicit KD_TREE_INGEST(TreePtr tree = TreePtr(), double voxelSize = 0.2,
+                            int queueCapacity = DEFAULT_QUEUE_CAPACITY, OverflowPolicy overflowPolicy = RejectWhenFull)
+        : m_tree(tree ? tree : TreePtr(new TreeType())), m_voxelSize(voxelSize),
+          m_queueCapacity(qMax(1, queueCapacity)), m_overflowPolicy(overflowPolicy)
+    {
+        m_clock.start();
+        for (int stage = 0; stage < STAGE_COUNT; stage++) {
+            m_stageThreads[stage].reset(QThread::create([this, stage]() { this->stageLoop(stage); }));
+            m_stageThreads[stage]->start();
         }
     }
-
-    void runOperation(KD_TREE_NODE** root, const Operation_Logger_Type& operation) {
-        switch (operation.op) {
-        case ADD_POINT:      
-            addByPoint(root, operation.point, false, (*root) ? (*root)->division_axis : 0);          
-            break;
-        case ADD_BOX:
-            addByRange(root, operation.boxpoint, false);
-            break;
-        case DELETE_POINT:
-            deleteByPoint(root, operation.point, false);
-            break;
-        case DELETE_BOX:
-            deleteByRange(root, operation.boxpoint, false, false);
-            break;
-        case DOWNSAMPLE_DELETE:
-            deleteByRange(root, operation.boxpoint, false, true);
-            break;
-        case PUSH_DOWN:
-            (*root)->tree_downsample_deleted |= operation.tree_downsample_deleted;
-            (*root)->point_downsample_deleted |= operation.tree_downsample_deleted;
-            (*root)->tree_deleted = operation.tree_deleted || (*root)->tree_downsample_deleted;
-            (*root)->point_deleted = (*root)->tree_deleted || (*root)->point_downsample_deleted;
-            if (operation.tree_downsample_deleted) (*root)->down_del_num = (*root)->TreeSize;
-            if (operation.tree_deleted) (*root)->invalid_point_num = (*root)->TreeSize;
-                else (*root)->invalid_point_num = (*root)->down_del_num;
-            (*root)->need_push_down_to_left = true;
-            (*root)->need_push_down_to_right = true;
-            break;
-        default:
-            break;
+    
+    /**
+     * @brief 析构函数 - 处理完已接受的帧后停止各阶段线程
+     */
+    ~KD_TREE_INGEST()
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stopping = true;
+            m_changed.wakeAll();
         }
+        for (int stage = 0; stage < STAGE_COUNT; stage++) m_stageThreads[stage]->wait();
     }
-
-    bool criterionCheck(KD_TREE_NODE* root) {
+    
+    /**
+     * @brief 提交一帧传感器坐标系下的扫描
+     * @return 帧被接受时为true；RejectWhenFull下输入队列已满时为false，开始析构后总是false
+     */
+    bool submitFrame(const PointVector& scan, const POSE& pose)
+    {
         /**
-         * @brief 检查是否需要重建判据实现 - 判断树是否需要重建以保持平衡
+         * @brief 提交帧实现 - 只把点集和位姿放入输入队列，变换在变换线程上进行
          */
-        if (root->TreeSize <= Minimal_Unbalanced_Tree_Size) {
+        FRAME frame;
+        frame.points = scan;
+        frame.pose = pose;
+        QMutexLocker locker(&m_mutex);
+        frame.submitNs = m_clock.nsecsElapsed();
+        if (m_stopping) {
+            m_framesDropped++;
             return false;
         }
-        
-        double balanceEvaluation = 0.0;
-        double deleteEvaluation = 0.0;
-        KD_TREE_NODE* sonPtr = root->left_son_ptr;
-        if (sonPtr == nullptr) sonPtr = root->right_son_ptr;
-        
-        deleteEvaluation = double(root->invalid_point_num) / root->TreeSize;
-        balanceEvaluation = double(sonPtr->TreeSize) / (root->TreeSize - 1);
-        
-        if (deleteEvaluation > m_deleteCriterionParam) {
-            return true;
-        }
-        
-        if (balanceEvaluation > m_balanceCriterionParam || balanceEvaluation < 1 - m_balanceCriterionParam) {
-            return true;
+        while (m_queues[TransformStage].size() >= m_queueCapacity) {
+            if (m_overflowPolicy == RejectWhenFull || m_stopping) {
+                m_framesDropped++;
+                return false;
+            }
+            m_changed.wait(&m_mutex);
         }
-        
-        return false;
+        m_queues[TransformStage].enqueue(frame);
+        m_framesSubmitted++;
+        m_inFlight++;
+        m_changed.wakeAll();
+        return true;
     }
-
-    void pushDown(KD_TREE_NODE* root) {
-        /**
-         * @brief 下推操作实现 - 将删除标记下推到子节点
-         */
-        if (root == nullptr) return;
+    
+    /**
+     * @brief 等待已接受的帧全部插入完成
+     */
+    void waitForIdle()
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_inFlight > 0) m_changed.wait(&m_mutex);
+    }
+    
+    /**
+     * @brief 已接受但尚未插入完成的帧数
+     */
+    int framesInFlight() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_inFlight;
+    }
+    
+    /**
+     * @brief 获取统计
+     */
+    STATS stats() const
+    {
+        QMutexLocker locker(&m_mutex);
+        STATS result;
+        for (int stage = 0; stage < STAGE_COUNT; stage++) result.stages[stage] = m_stageStats[stage];
+        result.framesSubmitted = m_framesSubmitted;
+        result.framesDropped = m_framesDropped;
+        result.framesInserted = m_stageStats[InsertStage].frames;
+        result.meanLatencyMs = result.framesInserted > 0 ? m_latencyMs / result.framesInserted : 0.0;
+        result.maxLatencyMs = m_maxLatencyMs;
+        result.elapsedMs = (m_clock.nsecsElapsed() - m_statsStartNs) / 1e6;
+        return result;
+    }
+    
+    /**
+     * @brief 清零统计并重新开始计时
+     */
+    void resetStats()
+    {
+        QMutexLocker locker(&m_mutex);
+        for (int stage = 0; stage < STAGE_COUNT; stage++) m_stageStats[stage] = STAGE_STATS();
+        m_framesSubmitted = 0;
+        m_framesDropped = 0;
+        m_latencyMs = 0.0;
+        m_maxLatencyMs = 0.0;
+        m_statsStartNs = m_clock.nsecsElapsed();
+    }
+    
+    /**
+     * @brief 访问被写入的树，可在任意线程查询
+     */
+    TreePtr tree() const
+    {
+        return m_tree;
+    }
+    
+private:
+    /**
+     * @brief 流水线中的一帧
+     */
+    struct FRAME
+    {
+        PointVector points;     ///< 当前阶段的点集
+        POSE pose;              ///< 扫描时的位姿
+        qint64 submitNs = 0;    ///< 提交时刻
+    };
+    
+    /**
+     * @brief 体素哈希键 - 保留三轴完整的整数坐标，任意两个不同体素的键不相同
+     */
+    struct VOXEL_KEY
+    {
+        int x;  ///< x轴体素坐标
+        int y;  ///< y轴体素坐标
+        int z;  ///< z轴体素坐标
         
-        Operation_Logger_Type operation;
-        operation.op = PUSH_DOWN;
-        operation.tree_deleted = root->tree_deleted;
-        operation.tree_downsample_deleted = root->tree_downsample_deleted;
+        bool operator==(const VOXEL_KEY& other) const { return x == other.x && y == other.y && z == other.z; }
         
-        if (root->need_push_down_to_left && root->left_son_ptr != nullptr) {
-            if (m_rebuildPtr == nullptr || *m_rebuildPtr != root->left_son_ptr) {
-                root->left_son_ptr->tree_downsample_deleted |= root->tree_downsample_deleted;
-                root->left_son_ptr->point_downsample_deleted |= root->tree_downsample_deleted;
-                root->left_son_ptr->tree_deleted = root->tree_deleted || root->left_son_ptr->tree_downsample_deleted;
-                root->left_son_ptr->point_deleted = root->left_son_ptr->tree_deleted || root->left_son_ptr->point_downsample_deleted;
-                if (root->tree_downsample_deleted) root->left_son_ptr->down_del_num = root->left_son_ptr->TreeSize;
-                if (root->tree_deleted) root->left_son_ptr->invalid_point_num = root->left_son_ptr->TreeSize;
-                    else root->left_son_ptr->invalid_point_num = root->left_son_ptr->down_del_num;
-                root->left_son_ptr->need_push_down_to_left = true;
-                root->left_son_ptr->need_push_down_to_right = true;
-                root->need_push_down_to_left = false;
-            } else {
-                QMutexLocker locker(&m_workingFlagMutex);
-                root->left_son_ptr->tree_downsample_deleted |= root->tree_downsample_deleted;
-                root->left_son_ptr->point_downsample_deleted |= root->tree_downsample_deleted;
-                root->left_son_ptr->tree_deleted = root->tree_deleted || root->left_son_ptr->tree_downsample_deleted;
-                root->left_son_ptr->point_deleted = root->left_son_ptr->tree_deleted || root->left_son_ptr->point_downsample_deleted;
-                if (root->tree_downsample_deleted) root->left_son_ptr->down_del_num = root->left_son_ptr->TreeSize;
-                if (root->tree_deleted) root->left_son_ptr->invalid_point_num = root->left_son_ptr->TreeSize;
-                    else root->left_son_ptr->invalid_point_num = root->left_son_ptr->down_del_num;
-                root->left_son_ptr->need_push_down_to_left = true;
-                root->left_son_ptr->need_push_down_to_right = true;
-                if (m_rebuildFlag.loadRelaxed()) {
-                    QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                    m_rebuildLogger.push(operation);
-                }
-                root->need_push_down_to_left = false;
+        friend size_t qHash(const VOXEL_KEY& key, size_t seed = 0) { return qHashMulti(seed, key.x, key.y, key.z); }
+    };
+    
+    /**
+     * @brief 阶段线程主循环 - 从本阶段队列取帧，处理后放入下一阶段队列
+     *
+     * 停止时上游阶段全部退出且本阶段队列为空后才退出，已接受的帧都会被插入
+     */
+    void stageLoop(int stage)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (true) {
+            while (m_queues[stage].isEmpty() && !(m_stopping && m_finishedStages >= stage)) m_changed.wait(&m_mutex);
+            if (m_queues[stage].isEmpty()) break;
+            FRAME frame = m_queues[stage].dequeue();
+            m_changed.wakeAll();
+            locker.unlock();
+            
+            const qint64 pointsIn = frame.points.size();
+            const qint64 startNs = m_clock.nsecsElapsed();
+            qint64 pointsOut = 0;
+            switch (stage) {
+            case TransformStage:
+                transformFrame(frame);
+                pointsOut = frame.points.size();
+                break;
+            case FilterStage:
+                filterFrame(frame);
+                pointsOut = frame.points.size();
+                break;
+            default:
+                pointsOut = m_tree->addPoints(frame.points, m_voxelSize > 0.0);
+                frame.points = PointVector();
+                break;
             }
-        }
-        
-        if (root->need_push_down_to_right && root->right_son_ptr != nullptr) {
-            if (m_rebuildPtr == nullptr || *m_rebuildPtr != root->right_son_ptr) {
-                root->right_son_ptr->tree_downsample_deleted |= root->tree_downsample_deleted;
-                root->right_son_ptr->point_downsample_deleted |= root->tree_downsample_deleted;
-                root->right_son_ptr->tree_deleted = root->tree_deleted || root->right_son_ptr->tree_downsample_deleted;
-                root->right_son_ptr->point_deleted = root->right_son_ptr->tree_deleted || root->right_son_ptr->point_downsample_deleted;
-                if (root->tree_downsample_deleted) root->right_son_ptr->down_del_num = root->right_son_ptr->TreeSize;
-                if (root->tree_deleted) root->right_son_ptr->invalid_point_num = root->right_son_ptr->TreeSize;
-                    else root->right_son_ptr->invalid_point_num = root->right_son_ptr->down_del_num;
-                root->right_son_ptr->need_push_down_to_left = true;
-                root->right_son_ptr->need_push_down_to_right = true;
-                root->need_push_down_to_right = false;
-            } else {
-                QMutexLocker locker(&m_workingFlagMutex);
-                root->right_son_ptr->tree_downsample_deleted |= root->tree_downsample_deleted;
-                root->right_son_ptr->point_downsample_deleted |= root->tree_downsample_deleted;
-                root->right_son_ptr->tree_deleted = root->tree_deleted || root->right_son_ptr->tree_downsample_deleted;
-                root->right_son_ptr->point_deleted = root->right_son_ptr->tree_deleted || root->right_son_ptr->point_downsample_deleted;
-                if (root->tree_downsample_deleted) root->right_son_ptr->down_del_num = root->right_son_ptr->TreeSize;
-                if (root->tree_deleted) root->right_son_ptr->invalid_point_num = root->right_son_ptr->TreeSize;
-                    else root->right_son_ptr->invalid_point_num = root->right_son_ptr->down_del_num;
-                root->right_son_ptr->need_push_down_to_left = true;
-                root->right_son_ptr->need_push_down_to_right = true;
-                if (m_rebuildFlag.loadRelaxed()) {
-                    QMutexLocker loggerLocker(&m_rebuildLoggerMutex);
-                    m_rebuildLogger.push(operation);
-                }
-                root->need_push_down_to_right = false;
+            const qint64 endNs = m_clock.nsecsElapsed();
+            
+            locker.relock();
+            STAGE_STATS& stats = m_stageStats[stage];
+            stats.frames++;
+            stats.pointsIn += pointsIn;
+            stats.pointsOut += pointsOut;
+            stats.busyMs += (endNs - startNs) / 1e6;
+            stats.maxMs = qMax(stats.maxMs, (endNs - startNs) / 1e6);
+            if (stage == InsertStage) {
+                const double latencyMs = (endNs - frame.submitNs) / 1e6;
+                m_latencyMs += latencyMs;
+                m_maxLatencyMs = qMax(m_maxLatencyMs, latencyMs);
+                m_inFlight--;
+                m_changed.wakeAll();
+                continue;
             }
+            while (m_queues[stage + 1].size() >= m_queueCapacity) m_changed.wait(&m_mutex);
+            m_queues[stage + 1].enqueue(frame);
+            m_changed.wakeAll();
         }
+        m_finishedStages = stage + 1;
+        m_changed.wakeAll();
     }
-
-    void update(KD_TREE_NODE* root) {
+    
+    /**
+     * @brief 变换阶段 - 把点集变换到世界坐标系
+     */
+    static void transformFrame(FRAME& frame)
+    {
+        PointVector world(frame.points.size());
+        const PointType* source = frame.points.constData();
+        PointType* target = world.data();
+        for (int i = 0; i < world.size(); i++) target[i] = frame.pose.apply(source[i]);
+        frame.points = world;
+    }
+    
+    /**
+     * @brief 滤波阶段 - 每个体素保留离体素中心最近的点，网格和距离计算与KD_TREE的下采样相同
+     *
+     * 树按floor确定点的体素、按vertex_min <= x < vertex_max检索体素内已有的点，坐标恰在体素边界上时二者可能不一致，
+     * 压缩叶块的量化坐标常落在边界上。这样的点及其涉及的体素原样按帧内顺序输出，交给树的下采样处理
+     */
+    void filterFrame(FRAME& frame) const
+    {
         /**
-         * @brief 更新节点信息实现 - 更新统计信息和包围盒
+         * @brief 体素滤波实现 - 输出按体素首次出现的顺序排列
          */
-        if (!root) return;
+        if (m_voxelSize <= 0.0 || frame.points.isEmpty()) return;
+        // 树按对齐后的坐标下采样，滤波须看到同样的坐标
+        m_tree->snapToLeafGrid(frame.points);
+        const PointVector& points = frame.points;
         
-        KD_TREE_NODE* leftSonPtr = root->left_son_ptr;
-        KD_TREE_NODE* rightSonPtr = root->right_son_ptr;
-        double tmpRangeX[2] = {std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
-        double tmpRangeY[2] = {std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
-        double tmpRangeZ[2] = {std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
-        
-        // 更新树大小
-        if (leftSonPtr != nullptr && rightSonPtr != nullptr) {
-            root->TreeSize = leftSonPtr->TreeSize + rightSonPtr->TreeSize + 1;
-            root->invalid_point_num = leftSonPtr->invalid_point_num + rightSonPtr->invalid_point_num + (root->point_deleted ? 1 : 0);
-            root->down_del_num = leftSonPtr->down_del_num + rightSonPtr->down_del_num + (root->point_downsample_deleted ? 1 : 0);
-            root->tree_downsample_deleted = leftSonPtr->tree_downsample_deleted && rightSonPtr->tree_downsample_deleted && root->point_downsample_deleted;
-            root->tree_deleted = leftSonPtr->tree_deleted && rightSonPtr->tree_deleted && root->point_deleted;
-            
-            if (root->tree_deleted || (!leftSonPtr->tree_deleted && !rightSonPtr->tree_deleted && !root->point_deleted)) {
-                tmpRangeX[0] = qMin(qMin(leftSonPtr->node_range_x[0], rightSonPtr->node_range_x[0]), root->point.x);
-                tmpRangeX[1] = qMax(qMax(leftSonPtr->node_range_x[1], rightSonPtr->node_range_x[1]), root->point.x);
-                tmpRangeY[0] = qMin(qMin(leftSonPtr->node_range_y[0], rightSonPtr->node_range_y[0]), root->point.y);
-                tmpRangeY[1] = qMax(qMax(leftSonPtr->node_range_y[1], rightSonPtr->node_range_y[1]), root->point.y);
-                tmpRangeZ[0] = qMin(qMin(leftSonPtr->node_range_z[0], rightSonPtr->node_range_z[0]), root->point.z);
-                tmpRangeZ[1] = qMax(qMax(leftSonPtr->node_range_z[1], rightSonPtr->node_range_z[1]), root->point.z);
-            } else {
-                if (!leftSonPtr->tree_deleted) {
-                    tmpRangeX[0] = qMin(tmpRangeX[0], leftSonPtr->node_range_x[0]);
-                    tmpRangeX[1] = qMax(tmpRangeX[1], leftSonPtr->node_range_x[1]);
-                    tmpRangeY[0] = qMin(tmpRangeY[0], leftSonPtr->node_range_y[0]);
-                    tmpRangeY[1] = qMax(tmpRangeY[1], leftSonPtr->node_range_y[1]);
-                    tmpRangeZ[0] = qMin(tmpRangeZ[0], leftSonPtr->node_range_z[0]);
-                    tmpRangeZ[1] = qMax(tmpRangeZ[1], leftSonPtr->node_range_z[1]);
-                }
-                if (!rightSonPtr->tree_deleted) {
-                    tmpRangeX[0] = qMin(tmpRangeX[0], rightSonPtr->node_range_x[0]);
-                    tmpRangeX[1] = qMax(tmpRangeX[1], rightSonPtr->node_range_x[1]);
-                    tmpRangeY[0] = qMin(tmpRangeY[0], rightSonPtr->node_range_y[0]);
-                    tmpRangeY[1] = qMax(tmpRangeY[1], rightSonPtr->node_range_y[1]);
-                    tmpRangeZ[0] = qMin(tmpRangeZ[0], rightSonPtr->node_range_z[0]);
-                    tmpRangeZ[1] = qMax(tmpRangeZ[1], rightSonPtr->node_range_z[1]);
-                }
-                if (!root->point_deleted) {
-                    tmpRangeX[0] = qMin(tmpRangeX[0], root->point.x);
-                    tmpRangeX[1] = qMax(tmpRangeX[1], root->point.x);
-                    tmpRangeY[0] = qMin(tmpRangeY[0], root->point.y);
-                    tmpRangeY[1] = qMax(tmpRangeY[1], root->point.y);
-                    tmpRangeZ[0] = qMin(tmpRangeZ[0], root->point.z);
-                    tmpRangeZ[1] = qMax(tmpRangeZ[1], root->point.z);
+        // 与KD_TREE::downsampleBox相同的体素边界
+        auto inCell = [this](int cell, Scalar value) {
+            const Scalar low = Scalar(cell * m_voxelSize);
+            const Scalar high = Scalar(low + m_voxelSize);
+            return low <= value && high > value;
+        };
+        
+        // 第一遍：标记检索范围与体素不一致的点，其所在体素和被其检索框覆盖的体素不再滤波
+        constexpr int PASS_THROUGH = -1;
+        QHash<VOXEL_KEY, int> voxels;
+        voxels.reserve(points.size());
+        QVector<VOXEL_KEY> keys(points.size());
+        QVector<bool> ambiguous(points.size(), false);
+        for (int i = 0; i < points.size(); i++) {
+            const PointType& point = points[i];
+            const Scalar coords[3] = {point.x, point.y, point.z};
+            int cells[3];
+            int candidates[3][2];
+            int candidateCount[3];
+            for (int axis = 0; axis < 3; axis++) {
+                cells[axis] = qFloor(coords[axis] / m_voxelSize);
+                candidateCount[axis] = 0;
+                for (int cell = cells[axis] - 1; cell <= cells[axis] + 1; cell++) {
+                    if (!inCell(cell, coords[axis])) continue;
+                    if (cell != cells[axis] || candidateCount[axis] == 2) ambiguous[i] = true;
+                    if (candidateCount[axis] < 2) candidates[axis][candidateCount[axis]++] = cell;
                 }
+                if (!inCell(cells[axis], coords[axis])) ambiguous[i] = true;
             }
-        } else if (leftSonPtr != nullptr) {
-            root->TreeSize = leftSonPtr->TreeSize + 1;
-            root->invalid_point_num = leftSonPtr->invalid_point_num + (root->point_deleted ? 1 : 0);
-            root->down_del_num = leftSonPtr->down_del_num + (root->point_downsample_deleted ? 1 : 0);
-            root->tree_downsample_deleted = leftSonPtr->tree_downsample_deleted && root->point_downsample_deleted;
-            root->tree_deleted = leftSonPtr->tree_deleted && root->point_deleted;
-            
-            if (root->tree_deleted || (!leftSonPtr->tree_deleted && !root->point_deleted)) {
-                tmpRangeX[0] = qMin(leftSonPtr->node_range_x[0], root->point.x);
-                tmpRangeX[1] = qMax(leftSonPtr->node_range_x[1], root->point.x);
-                tmpRangeY[0] = qMin(leftSonPtr->node_range_y[0], root->point.y);
-                tmpRangeY[1] = qMax(leftSonPtr->node_range_y[1], root->point.y);
-                tmpRangeZ[0] = qMin(leftSonPtr->node_range_z[0], root->point.z);
-                tmpRangeZ[1] = qMax(leftSonPtr->node_range_z[1], root->point.z);
-            } else {
-                if (!leftSonPtr->tree_deleted) {
-                    tmpRangeX[0] = qMin(tmpRangeX[0], leftSonPtr->node_range_x[0]);
-                    tmpRangeX[1] = qMax(tmpRangeX[1], leftSonPtr->node_range_x[1]);
-                    tmpRangeY[0] = qMin(tmpRangeY[0], leftSonPtr->node_range_y[0]);
-                    tmpRangeY[1] = qMax(tmpRangeY[1], leftSonPtr->node_range_y[1]);
-                    tmpRangeZ[0] = qMin(tmpRangeZ[0], leftSonPtr->node_range_z[0]);
-                    tmpRangeZ[1] = qMax(tmpRangeZ[1], leftSonPtr->node_range_z[1]);
-                }
-                if (!root->point_deleted) {
-                    tmpRangeX[0] = qMin(tmpRangeX[0], root->point.x);
-                    tmpRangeX[1] = qMax(tmpRangeX[1], root->point.x);
-                    tmpRangeY[0] = qMin(tmpRangeY[0], root->point.y);
-                    tmpRangeY[1] = qMax(tmpRangeY[1], root->point.y);
-                    tmpRangeZ[0] = qMin(tmpRangeZ[0], root->point.z);
-                    tmpRangeZ[1] = qMax(tmpRangeZ[1], root->point.z);
+            keys[i] = VOXEL_KEY{cells[0], cells[1], cells[2]};
+            if (!ambiguous[i]) continue;
+            voxels.insert(keys[i], PASS_THROUGH);
+            for (int a = 0; a < candidateCount[0]; a++) {
+                for (int b = 0; b < candidateCount[1]; b++) {
+                    for (int c = 0; c < candidateCount[2]; c++) {
+                        voxels.insert(VOXEL_KEY{candidates[0][a], candidates[1][b], candidates[2][c]}, PASS_THROUGH);
+                    }
                 }
             }
-        } else if (rightSonPtr != nullptr) {
-            root->TreeSize = rightSonPtr->TreeSize + 1;
-            root->invalid_point_num = rightSonPtr->invalid_point_num + (root->point_deleted ? 1 : 0);
-            root->down_del_num = rightSonPtr->down_del_num + (root->point_downsample_deleted ? 1 : 0);
-            root->tree_downsample_deleted = rightSonPtr->tree_downsample_deleted && root->point_downsample_deleted;
-            root->tree_deleted = rightSonPtr->tree_deleted && root->point_deleted;
+        }
+        
+        // 第二遍：其余体素保留离体素中心最近的点
+        PointVector filtered;
+        QVector<Scalar> bestDist;
+        filtered.reserve(points.size());
+        bestDist.reserve(points.size());
+        for (int i = 0; i < points.size(); i++) {
+            const PointType& point = points[i];
+            const VOXEL_KEY& key = keys[i];
+            auto it = voxels.find(key);
+            if (ambiguous[i] || (it != voxels.end() && it.value() == PASS_THROUGH)) {
+                filtered.append(point);
+                bestDist.append(Scalar(0));
+                continue;
+            }
+            BoxType box;
+            box.vertex_min[0] = key.x * m_voxelSize;
+            box.vertex_max[0] = box.vertex_min[0] + m_voxelSize;
+            box.vertex_min[1] = key.y * m_voxelSize;
+            box.vertex_max[1] = box.vertex_min[1] + m_voxelSize;
+            box.vertex_min[2] = key.z * m_voxelSize;
+            box.vertex_max[2] = box.vertex_min[2] + m_voxelSize;
+            PointType midPoint;
+            midPoint.x = box.vertex_min[0] + (box.vertex_max[0] - box.vertex_min[0]) / 2.0;
+            midPoint.y = box.vertex_min[1] + (box.vertex_max[1] - box.vertex_min[1]) / 2.0;
+            midPoint.z = box.vertex_min[2] + (box.vertex_max[2] - box.vertex_min[2]) / 2.0;
+            const Scalar dist = (point.x - midPoint.x) * (point.x - midPoint.x) + (point.y - midPoint.y) * (point.y - midPoint.y) +
+                                (point.z - midPoint.z) * (point.z - midPoint.z);
             
-            if (root->tree_deleted || (!rightSonPtr->tree_deleted && !root->point_deleted)) {
-                tmpRangeX[0] = qMin(rightSonPtr->node_range_x[0], root->point.x);
-                tmpRangeX[1] = qMax(rightSonPtr->node_range_x[1], root->point.x);
-                tmpRangeY[0] = qMin(rightSonPtr->node_range_y[0], root->point.y);
-                tmpRangeY[1] = qMax(rightSonPtr->node_range_y[1], root->point.y);
-                tmpRangeZ[0] = qMin(rightSonPtr->node_range_z[0], root->point.z);
-                tmpRangeZ[1] = qMax(rightSonPtr->node_range_z[1], root->point.z);
-            } else {
-                if (!rightSonPtr->tree_deleted) {
-                    tmpRangeX[0] = qMin(tmpRangeX[0], rightSonPtr->node_range_x[0]);
-                    tmpRangeX[1] = qMax(tmpRangeX[1], rightSonPtr->node_range_x[1]);
-                    tmpRangeY[0] = qMin(tmpRangeY[0], rightSonPtr->node_range_y[0]);
-                    tmpRangeY[1] = qMax(tmpRangeY[1], rightSonPtr->node_range_y[1]);
-                    tmpRangeZ[0] = qMin(tmpRangeZ[0], rightSonPtr->node_range_z[0]);
-                    tmpRangeZ[1] = qMax(tmpRangeZ[1], rightSonPtr->node_range_z[1]);
-                }
-                if (!root->point_deleted) {
-                    tmpRangeX[0] = qMin(tmpRangeX[0], root->point.x);
-                    tmpRangeX[1] = qMax(tmpRangeX[1], root->point.x);
-                    tmpRangeY[0] = qMin(tmpRangeY[0], root->point.y);
-                    tmpRangeY[1] = qMax(tmpRangeY[1], root->point.y);
-                    tmpRangeZ[0] = qMin(tmpRangeZ[0], root->point.z);
-                    tmpRangeZ[1] = qMax(tmpRangeZ[1], root->point.z);
-                }
+            if (it == voxels.end()) {
+                voxels.insert(key, filtered.size());
+                filtered.append(point);
+                bestDist.append(dist);
+            } else if (dist <= bestDist[it.value()]) {
+                filtered[it.value()] = point;
+                bestDist[it.value()] = dist;
             }
-        } else {
-            root->TreeSize = 1;
-            root->invalid_point_num = (root->point_deleted ? 1 : 0);
-            root->down_del_num = (root->point_downsample_deleted ? 1 : 0);
-            root->tree_downsample_deleted = root->point_downsample_deleted;
-            root->tree_deleted = root->point_deleted;
-            tmpRangeX[0] = root->point.x;
-            tmpRangeX[1] = root->point.x;        
-            tmpRangeY[0] = root->point.y;
-            tmpRangeY[1] = root->point.y; 
-            tmpRangeZ[0] = root->point.z;
-            tmpRangeZ[1] = root->point.z;                 
-        }
-        
-        // 复制范围数据
-        memcpy(root->node_range_x, tmpRangeX, sizeof(tmpRangeX));
-        memcpy(root->node_range_y, tmpRangeY, sizeof(tmpRangeY));
-        memcpy(root->node_range_z, tmpRangeZ, sizeof(tmpRangeZ));
-        
-        double xL = (root->node_range_x[1] - root->node_range_x[0]) * 0.5;
-        double yL = (root->node_range_y[1] - root->node_range_y[0]) * 0.5;
-        double zL = (root->node_range_z[1] - root->node_range_z[0]) * 0.5;
-        root->radius_sq = xL*xL + yL*yL + zL*zL;
-        
-        if (leftSonPtr != nullptr) leftSonPtr->father_ptr = root;
-        if (rightSonPtr != nullptr) rightSonPtr->father_ptr = root;
-        
-        if (root == m_rootNode && root->TreeSize > 3) {
-            KD_TREE_NODE* sonPtr = root->left_son_ptr;
-            if (sonPtr == nullptr) sonPtr = root->right_son_ptr;
-            double tmpBal = double(sonPtr->TreeSize) / (root->TreeSize - 1);
-            root->alpha_del = double(root->invalid_point_num) / root->TreeSize;
-            root->alpha_bal = (tmpBal >= 0.5 - EPSS) ? tmpBal : 1 - tmpBal;
         }
+        frame.points = filtered;
     }
-
-    void deleteTreeNodes(KD_TREE_NODE** root) {
-        /**
-         * @brief 删除树节点实现 - 递归删除整个子树
-         */
-        if (*root == nullptr) return;
-        
-        pushDown(*root);
-        deleteTreeNodes(&(*root)->left_son_ptr);
-        deleteTreeNodes(&(*root)->right_son_ptr);
-        
-        delete *root;
-        *root = nullptr;
-    }
-
-    bool samePoint(const PointType& a, const PointType& b) const {
-        /**
-         * @brief 判断点是否相同实现
-         */
-        return (qAbs(a.x - b.x) < EPSS && qAbs(a.y - b.y) < EPSS && qAbs(a.z - b.z) < EPSS);
-    }
-
-    double calcDist(const PointType& a, const PointType& b) const {
-        /**
-         * @brief 计算点间距离实现
-         */
-        double dist = (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z);
-        return dist;
-    }
-
-    double calcBoxDist(const KD_TREE_NODE* node, const PointType& point) const {
-        /**
-         * @brief 计算点到包围盒距离实现
-         */
-        if (node == nullptr) return std::numeric_limits<double>::infinity();
-        
-        double minDist = 0.0;
-        if (point.x < node->node_range_x[0]) minDist += (point.x - node->node_range_x[0]) * (point.x - node->node_range_x[0]);
-        if (point.x > node->node_range_x[1]) minDist += (point.x - node->node_range_x[1]) * (point.x - node->node_range_x[1]);
-        if (point.y < node->node_range_y[0]) minDist += (point.y - node->node_range_y[0]) * (point.y - node->node_range_y[0]);
-        if (point.y > node->node_range_y[1]) minDist += (point.y - node->node_range_y[1]) * (point.y - node->node_range_y[1]);
-        if (point.z < node->node_range_z[0]) minDist += (point.z - node->node_range_z[0]) * (point.z - node->node_range_z[0]);
-        if (point.z > node->node_range_z[1]) minDist += (point.z - node->node_range_z[1]) * (point.z - node->node_range_z[1]);
-        return minDist;
-    }
-
-    static bool pointCmpX(const PointType& a, const PointType& b) {
-        return a.x < b.x;
-    }
-
-    static bool pointCmpY(const PointType& a, const PointType& b) {
-        return a.y < b.y;
-    }
-
-    static bool pointCmpZ(const PointType& a, const PointType& b) {
-        return a.z < b.z;
-    }
+    
+    TreePtr m_tree;                                     ///< 被写入的树
+    const double m_voxelSize;                           ///< 体素滤波边长
+    const int m_queueCapacity;                          ///< 每个队列容纳的帧数
+    const OverflowPolicy m_overflowPolicy;              ///< 输入队列已满时的处理方式
+    mutable QMutex m_mutex;                             ///< 保护队列和统计的互斥锁
+    QWaitCondition m_changed;                           ///< 队列或完成状态变化条件
+    QQueue<FRAME> m_queues[STAGE_COUNT];                ///< 各阶段的输入队列
+    QScopedPointer<QThread> m_stageThreads[STAGE_COUNT];///< 各阶段线程
+    STAGE_STATS m_stageStats[STAGE_COUNT];              ///< 各阶段统计
+    qint64 m_framesSubmitted = 0;                       ///< 被接受的帧数
+    qint64 m_framesDropped = 0;                         ///< 被丢弃的帧数
+    double m_latencyMs = 0.0;                           ///< 端到端延迟之和
+    double m_maxLatencyMs = 0.0;                        ///< 最长端到端延迟
+    qint64 m_statsStartNs = 0;                          ///< 统计区间起点
+    int m_inFlight = 0;                                 ///< 已接受但尚未插入完成的帧数
+    int m_finishedStages = 0;                           ///< 已退出的阶段数，阶段按顺序退出
+    bool m_stopping = false;                            ///< 是否正在停止
+    QElapsedTimer m_clock;                              ///< 计时器
 };
 
 // 为兼容性提供的类型别名
 using IkdTree = KD_TREE<DefaultPointType>;
 using IkdTreePtr = QSharedPointer<IkdTree>;
+using SingleThreadedIkdTree = KD_TREE<DefaultPointType, SingleThreaded>;
+using IkdForest = KD_TREE_FOREST<DefaultPointType>;
+using IkdTreeAsync = KD_TREE_ASYNC<DefaultPointType>;
+using IkdTreeIngest = KD_TREE_INGEST<DefaultPointType>;
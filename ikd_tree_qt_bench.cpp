@@ -0,0 +1,248 @@
+/**
+ * @file ikd_tree_qt_bench.cpp
+ * @brief ikd-Tree无界面性能基准
+ *
+ * --mode knn比较nearestSearchBatch与逐个调用nearestSearch的吞吐量：对每个地图规模构建一次树，
+ * 同一组查询两种方式各运行若干遍取最快一遍，报告单查询耗时、吞吐量与加速比，并核对两种方式结果逐位一致。
+ *
+ * --mode ingest以合成的激光扫描测量KD_TREE_INGEST：先串行执行“变换→addPoints(points, true)”得到单线程上限，
+ * 再让流水线满负荷运行报告各阶段耗时和帧率，最后按给定频率持续提交，报告插入、丢弃的帧数与端到端延迟。
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+#include "ikd_Tree_qt.hpp"
+
+using PointType = ikdTree_PointType<int>;
+using Tree = KD_TREE<PointType>;
+using Ingest = KD_TREE_INGEST<PointType>;
+
+/**
+ * @brief 基准参数
+ */
+struct BENCH_OPTIONS {
+    QVector<int> mapSizes;
+    int queries = 100000;
+    int k = 5;
+    int repeat = 3;
+    double extent = 100.0;
+    int frames = 60;
+    int scanPoints = 20000;
+    QVector<int> ratesHz;
+    double voxelSize = 0.2;
+};
+
+/**
+ * @brief 在[-extent, extent)^3内均匀取点
+ */
+static PointType randomPoint(QRandomGenerator& rng, double extent, int data = 0)
+{
+    return PointType(rng.bounded(2.0 * extent) - extent,
+                     rng.bounded(2.0 * extent) - extent,
+                     rng.bounded(2.0 * extent) - extent, data);
+}
+
+/**
+ * @brief 批量与逐个K近邻吞吐量对比，返回结果不一致的查询数
+ */
+static qint64 runKnnBench(const BENCH_OPTIONS& options, QTextStream& out)
+{
+    out << "queries=" << options.queries << " k=" << options.k << " repeat=" << options.repeat
+        << " group=" << Tree::BATCH_SEARCH_GROUP << Qt::endl;
+    qint64 mismatches = 0;
+    for (int mapSize : options.mapSizes) {
+        QRandomGenerator rng(5);
+        QVector<PointType> points;
+        points.reserve(mapSize);
+        for (int i = 0; i < mapSize; i++) points.append(randomPoint(rng, options.extent, i));
+        Tree tree;
+        tree.build(points);
+
+        QVector<PointType> queries;
+        queries.reserve(options.queries);
+        for (int i = 0; i < options.queries; i++) queries.append(randomPoint(rng, options.extent));
+
+        QVector<QVector<PointType>> serialPoints(queries.size());
+        QVector<QVector<double>> serialDistances(queries.size());
+        QVector<QVector<PointType>> batchPoints;
+        QVector<QVector<double>> batchDistances;
+        qint64 serialBest = std::numeric_limits<qint64>::max();
+        qint64 batchBest = std::numeric_limits<qint64>::max();
+        QElapsedTimer timer;
+        for (int pass = 0; pass < options.repeat; pass++) {
+            timer.start();
+            for (int i = 0; i < queries.size(); i++) {
+                tree.nearestSearch(queries[i], options.k, serialPoints[i], serialDistances[i]);
+            }
+            serialBest = qMin(serialBest, timer.nsecsElapsed());
+
+            timer.restart();
+            tree.nearestSearchBatch(queries, options.k, batchPoints, batchDistances);
+            batchBest = qMin(batchBest, timer.nsecsElapsed());
+        }
+
+        for (int i = 0; i < queries.size(); i++) {
+            if (batchDistances[i] != serialDistances[i]) mismatches++;
+        }
+        const double serialUs = serialBest / 1e3 / queries.size();
+        const double batchUs = batchBest / 1e3 / queries.size();
+        out << "  map=" << mapSize
+            << u8" 逐个 " << serialUs << " us/q (" << 1e3 / serialUs << " kq/s)"
+            << u8" 批量 " << batchUs << " us/q (" << 1e3 / batchUs << " kq/s)"
+            << u8" 加速比 " << serialUs / batchUs << Qt::endl;
+    }
+    out << u8"  结果不一致的查询 " << mismatches << Qt::endl;
+    return mismatches;
+}
+
+/**
+ * @brief 合成一帧传感器坐标系下的环形扫描 - 方位均匀，距离为1.5米加指数分布，高度集中在地面附近
+ */
+static QVector<PointType> makeScan(QRandomGenerator& rng, int count)
+{
+    QVector<PointType> scan;
+    scan.reserve(count);
+    for (int i = 0; i < count; i++) {
+        const double azimuth = rng.bounded(2.0 * M_PI);
+        const double range = 1.5 - 6.0 * std::log(1.0 - rng.generateDouble());
+        const double height = (rng.bounded(4.5) - 1.5) * 0.3;
+        scan.append(PointType(range * std::cos(azimuth), range * std::sin(azimuth), height, i));
+    }
+    return scan;
+}
+
+/**
+ * @brief 第frame帧的传感器位姿 - 匀速前进并缓慢转向
+ */
+static Ingest::POSE poseAt(int frame)
+{
+    const double yaw = frame * 0.01;
+    return Ingest::POSE::fromQuaternion(std::cos(yaw / 2), 0, 0, std::sin(yaw / 2),
+                                        Vector3D(frame * 0.3, frame * 0.05, 0));
+}
+
+/**
+ * @brief 帧插入流水线基准，返回与串行结果不一致的次数
+ */
+static qint64 runIngestBench(const BENCH_OPTIONS& options, QTextStream& out)
+{
+    QRandomGenerator rng(7);
+    QVector<QVector<PointType>> scans;
+    for (int frame = 0; frame < options.frames; frame++) scans.append(makeScan(rng, options.scanPoints));
+    out << "frames=" << options.frames << " points/frame=" << options.scanPoints
+        << " voxel=" << options.voxelSize << Qt::endl;
+
+    // 串行参照：单线程逐帧变换后addPoints(points, true)
+    Tree::Ptr serialTree(new Tree(0.5, 0.6, options.voxelSize));
+    double transformMs = 0.0, insertMs = 0.0;
+    QElapsedTimer timer;
+    for (int frame = 0; frame < options.frames; frame++) {
+        timer.start();
+        const Ingest::POSE pose = poseAt(frame);
+        QVector<PointType> world;
+        world.reserve(scans[frame].size());
+        for (const PointType& point : scans[frame]) world.append(pose.apply(point));
+        transformMs += timer.nsecsElapsed() / 1e6;
+        timer.restart();
+        serialTree->addPoints(world, true);
+        insertMs += timer.nsecsElapsed() / 1e6;
+    }
+    out << u8"  串行: 变换 " << transformMs / options.frames << u8" ms/帧, 插入 " << insertMs / options.frames
+        << u8" ms/帧, 上限 " << options.frames * 1000.0 / (transformMs + insertMs) << u8" 帧/秒" << Qt::endl;
+
+    // 满负荷：提交线程在输入队列满时等待
+    Tree::Ptr pipelineTree(new Tree(0.5, 0.6, options.voxelSize));
+    {
+        Ingest ingest(pipelineTree, options.voxelSize, Ingest::DEFAULT_QUEUE_CAPACITY, Ingest::BlockWhenFull);
+        for (int frame = 0; frame < options.frames; frame++) ingest.submitFrame(scans[frame], poseAt(frame));
+        ingest.waitForIdle();
+        const Ingest::STATS stats = ingest.stats();
+        const char* stageNames[Ingest::STAGE_COUNT] = {"transform", "filter", "insert"};
+        for (int stage = 0; stage < Ingest::STAGE_COUNT; stage++) {
+            const Ingest::STAGE_STATS& stageStats = stats.stages[stage];
+            out << "    " << stageNames[stage] << u8": 输入 " << stageStats.pointsIn << u8" 输出 " << stageStats.pointsOut
+                << u8" 点, 平均 " << stageStats.meanMs() << u8" ms/帧, 最长 " << stageStats.maxMs << " ms, "
+                << stageStats.pointsPerSecond() / 1e6 << " Mpts/s" << Qt::endl;
+        }
+        out << u8"  满负荷: " << stats.framesPerSecond() << u8" 帧/秒, 延迟平均 " << stats.meanLatencyMs
+            << u8" ms 最长 " << stats.maxLatencyMs << " ms" << Qt::endl;
+    }
+
+    const bool same = serialTree->validnum() == pipelineTree->validnum();
+    out << u8"  有效点 串行 " << serialTree->validnum() << u8" 流水线 " << pipelineTree->validnum()
+        << (same ? u8" 一致" : u8" 不一致") << Qt::endl;
+
+    // 持续频率：按固定周期提交，输入队列满时丢帧
+    for (int rateHz : options.ratesHz) {
+        Tree::Ptr tree(new Tree(0.5, 0.6, options.voxelSize));
+        Ingest ingest(tree, options.voxelSize, Ingest::DEFAULT_QUEUE_CAPACITY, Ingest::RejectWhenFull);
+        const qint64 periodNs = 1000000000LL / rateHz;
+        QElapsedTimer clock;
+        clock.start();
+        for (int frame = 0; frame < options.frames; frame++) {
+            const qint64 waitNs = frame * periodNs - clock.nsecsElapsed();
+            if (waitNs > 0) QThread::usleep(waitNs / 1000);
+            ingest.submitFrame(scans[frame], poseAt(frame));
+        }
+        ingest.waitForIdle();
+        const Ingest::STATS stats = ingest.stats();
+        out << "  " << rateHz << u8" Hz: 插入 " << stats.framesInserted << u8" 丢弃 " << stats.framesDropped
+            << u8" 帧, 延迟平均 " << stats.meanLatencyMs << u8" ms 最长 " << stats.maxLatencyMs
+            << u8" ms, 插入阶段平均 " << stats.stages[Ingest::InsertStage].meanMs() << " ms" << Qt::endl;
+    }
+    return same ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ikd_tree_qt_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(u8"ikd-Tree性能基准");
+    parser.addHelpOption();
+    const QCommandLineOption modeOption("mode", u8"knn：批量与逐个K近邻对比；ingest：帧插入流水线", "mode", "knn");
+    const QCommandLineOption mapSizesOption("map-sizes", u8"逗号分隔的地图点数", "list", "100000,1000000");
+    const QCommandLineOption queriesOption("queries", u8"每轮查询数", "n", "100000");
+    const QCommandLineOption kOption("k", u8"近邻数", "n", "5");
+    const QCommandLineOption repeatOption("repeat", u8"重复遍数，取最快一遍", "n", "3");
+    const QCommandLineOption framesOption("frames", u8"ingest模式的帧数", "n", "60");
+    const QCommandLineOption scanPointsOption("scan-points", u8"ingest模式每帧点数", "n", "20000");
+    const QCommandLineOption ratesOption("rates", u8"ingest模式逗号分隔的提交频率（Hz）", "list", "5,10,20");
+    const QCommandLineOption voxelOption("voxel", u8"ingest模式的体素边长，与树的下采样边长相同", "m", "0.2");
+    parser.addOption(modeOption);
+    parser.addOption(framesOption);
+    parser.addOption(scanPointsOption);
+    parser.addOption(ratesOption);
+    parser.addOption(voxelOption);
+    parser.addOption(mapSizesOption);
+    parser.addOption(queriesOption);
+    parser.addOption(kOption);
+    parser.addOption(repeatOption);
+    parser.process(app);
+
+    BENCH_OPTIONS options;
+    for (const QString& size : parser.value(mapSizesOption).split(',')) {
+        if (size.toInt() > 0) options.mapSizes.append(size.toInt());
+    }
+    options.queries = qMax(1, parser.value(queriesOption).toInt());
+    options.k = qMax(1, parser.value(kOption).toInt());
+    options.repeat = qMax(1, parser.value(repeatOption).toInt());
+    options.frames = qMax(1, parser.value(framesOption).toInt());
+    options.scanPoints = qMax(1, parser.value(scanPointsOption).toInt());
+    for (const QString& rate : parser.value(ratesOption).split(',')) {
+        if (rate.toInt() > 0) options.ratesHz.append(rate.toInt());
+    }
+    options.voxelSize = parser.value(voxelOption).toDouble();
+
+    QTextStream out(stdout);
+    const bool ingestMode = parser.value(modeOption) == "ingest";
+    const qint64 failures = ingestMode ? runIngestBench(options, out) : runKnnBench(options, out);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,410 @@
+/**
+ * @file ikd_tree_qt_stress.cpp
+ * @brief ikd-Tree无界面并发压力测试
+ *
+ * 多个查询线程对一个写线程：写线程按预先生成的计划插入和删除，每完成一次修改发布一个步号；
+ * 查询线程抽样以暴力搜索校验K近邻结果，结果须与查询期间某一步的地图完全一致。
+ * 先只运行查询线程测得基准吞吐量，再与写线程同时运行，报告两种情况的查询吞吐量与写吞吐量。
+ *
+ * --mode writers测量多写者分区的扩展性：每个写线程只修改x方向上自己的一段，
+ * 写线程数从1逐次翻倍，同一计划先在分区深度0的树上串行执行作为参照，再在开启分区的树上并发执行，
+ * 报告两者的插入吞吐量与加速比，并比较两棵树的最终内容。
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QAtomicInt>
+#include <QVector>
+#include <climits>
+#include "ikd_Tree_qt.hpp"
+
+using PointType = ikdTree_PointType<int>;
+using Tree = KD_TREE<PointType>;
+
+/**
+ * @brief 计划中的一个点 - 在addStep步插入，在removeStep步删除（未删除时为INT_MAX）
+ */
+struct PLAN_POINT {
+    PointType point;
+    int addStep;
+    int removeStep;
+};
+
+/**
+ * @brief 写线程的修改计划
+ *
+ * 第0步为build，第v次操作占两步：2v-1插入addBatches[v]，2v删除removeBatches[v]
+ */
+struct WRITE_PLAN {
+    QVector<PointType> initial;
+    QVector<QVector<PointType>> addBatches;
+    QVector<QVector<PointType>> removeBatches;
+    QVector<PLAN_POINT> points;
+    int steps = 0;
+};
+
+/**
+ * @brief 压力测试参数
+ */
+struct STRESS_OPTIONS {
+    int readers = 4;
+    int initialPoints = 20000;
+    int operations = 400;
+    int batch = 200;
+    int k = 5;
+    int checkEvery = 8;
+    int baselineMs = 1000;
+    int writers = 4;
+    int partitionDepth = 3;
+    double extent = 50.0;
+};
+
+/**
+ * @brief 在[-extent, extent)^3内均匀取点
+ */
+static PointType randomPoint(QRandomGenerator& rng, double extent, int data = 0)
+{
+    return PointType(rng.bounded(2.0 * extent) - extent,
+                     rng.bounded(2.0 * extent) - extent,
+                     rng.bounded(2.0 * extent) - extent, data);
+}
+
+static double squaredDistance(const PointType& a, const PointType& b)
+{
+    const double dx = a.x - b.x;
+    const double dy = a.y - b.y;
+    const double dz = a.z - b.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+/**
+ * @brief 生成写计划 - 每次操作插入batch个新点，每4次操作删除约3/4批量的已有点
+ */
+static WRITE_PLAN makeWritePlan(const STRESS_OPTIONS& options)
+{
+    WRITE_PLAN plan;
+    QRandomGenerator rng(3);
+    for (int i = 0; i < options.initialPoints; i++) {
+        const PointType point = randomPoint(rng, options.extent, plan.points.size());
+        plan.initial.append(point);
+        plan.points.append(PLAN_POINT{point, 0, INT_MAX});
+    }
+    plan.addBatches.resize(options.operations + 1);
+    plan.removeBatches.resize(options.operations + 1);
+    for (int v = 1; v <= options.operations; v++) {
+        for (int i = 0; i < options.batch; i++) {
+            const PointType point = randomPoint(rng, options.extent, plan.points.size());
+            plan.addBatches[v].append(point);
+            plan.points.append(PLAN_POINT{point, 2 * v - 1, INT_MAX});
+        }
+        if (v % 4 != 0) continue;
+        for (int i = 0; i < options.batch * 3 / 4; i++) {
+            PLAN_POINT& victim = plan.points[rng.bounded(plan.points.size())];
+            if (victim.addStep < 2 * v - 1 && victim.removeStep == INT_MAX) {
+                victim.removeStep = 2 * v;
+                plan.removeBatches[v].append(victim.point);
+            }
+        }
+    }
+    plan.steps = 2 * options.operations;
+    return plan;
+}
+
+/**
+ * @brief 暴力校验 - 结果须与[firstStep, lastStep]中某一步地图的K近邻距离逐位相同
+ */
+static bool matchesSomeStep(const WRITE_PLAN& plan, const PointType& query, int k,
+                            const QVector<double>& distances, int firstStep, int lastStep)
+{
+    std::vector<double> expected;
+    for (int step = firstStep; step <= lastStep; step++) {
+        expected.clear();
+        for (const PLAN_POINT& point : plan.points) {
+            if (point.addStep <= step && step < point.removeStep) expected.push_back(squaredDistance(query, point.point));
+        }
+        const int count = qMin(k, int(expected.size()));
+        std::partial_sort(expected.begin(), expected.begin() + count, expected.end());
+        if (distances.size() != count) continue;
+        if (std::equal(distances.begin(), distances.end(), expected.begin())) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 多读者对单写者压力测试，返回校验失败次数
+ */
+static qint64 runReaderStress(const STRESS_OPTIONS& options, QTextStream& out)
+{
+    const WRITE_PLAN plan = makeWritePlan(options);
+    Tree tree(0.5, 0.6, 0.2);
+    tree.build(plan.initial);
+
+    QAtomicInt publishedStep(0);
+    QAtomicInt stopReaders(0);
+    QAtomicInteger<qint64> queries(0);
+    QAtomicInteger<qint64> validated(0);
+    QAtomicInteger<qint64> failures(0);
+
+    auto reader = [&](quint32 seed) {
+        QRandomGenerator rng(seed);
+        QVector<PointType> points;
+        QVector<double> distances;
+        qint64 count = 0;
+        while (!stopReaders.loadAcquire()) {
+            const PointType query = randomPoint(rng, options.extent);
+            const int firstStep = publishedStep.loadAcquire();
+            tree.nearestSearch(query, options.k, points, distances);
+            // 查询结束时写线程可能已完成下一步但尚未发布
+            const int lastStep = qMin(publishedStep.loadAcquire() + 1, plan.steps);
+            if (++count % options.checkEvery != 0) continue;
+            validated.fetchAndAddRelaxed(1);
+            if (!matchesSomeStep(plan, query, options.k, distances, firstStep, lastStep)) failures.fetchAndAddRelaxed(1);
+        }
+        queries.fetchAndAddRelaxed(count);
+    };
+
+    // withWriter为false时查询线程运行baselineMs毫秒，否则运行到写计划执行完毕
+    auto runPhase = [&](bool withWriter, double& queriesPerSecond, double& operationsPerSecond) {
+        queries.storeRelaxed(0);
+        stopReaders.storeRelease(0);
+        QVector<QThread*> threads;
+        for (int i = 0; i < options.readers; i++) {
+            threads.append(QThread::create([&reader, i]() { reader(quint32(100 + i)); }));
+        }
+        QElapsedTimer timer;
+        timer.start();
+        for (QThread* thread : threads) thread->start();
+        if (withWriter) {
+            for (int v = 1; v <= options.operations; v++) {
+                QVector<PointType> addBatch = plan.addBatches[v];
+                tree.addPoints(addBatch, false);
+                publishedStep.storeRelease(2 * v - 1);
+                QVector<PointType> removeBatch = plan.removeBatches[v];
+                if (!removeBatch.isEmpty()) tree.deletePoints(removeBatch);
+                publishedStep.storeRelease(2 * v);
+            }
+        } else {
+            QThread::msleep(options.baselineMs);
+        }
+        stopReaders.storeRelease(1);
+        for (QThread* thread : threads) thread->wait();
+        qDeleteAll(threads);
+        const double seconds = timer.nsecsElapsed() / 1e9;
+        queriesPerSecond = queries.loadRelaxed() / seconds;
+        operationsPerSecond = withWriter ? options.operations / seconds : 0.0;
+    };
+
+    double baselineQps = 0.0, unused = 0.0;
+    runPhase(false, baselineQps, unused);
+    double stressQps = 0.0, writerOps = 0.0;
+    runPhase(true, stressQps, writerOps);
+
+    qint64 live = 0;
+    for (const PLAN_POINT& point : plan.points) {
+        if (point.removeStep > plan.steps) live++;
+    }
+    if (live != tree.validnum()) failures.fetchAndAddRelaxed(1);
+
+    out << "readers=" << options.readers << " operations=" << options.operations
+        << " batch=" << options.batch << " k=" << options.k << Qt::endl;
+    out << u8"  只有查询: " << baselineQps << " q/s" << Qt::endl;
+    out << u8"  同时写入: " << stressQps << " q/s, writer " << writerOps << " ops/s ("
+        << writerOps * options.batch << " pts/s)" << Qt::endl;
+    out << u8"  校验 " << validated.loadRelaxed() << u8" 次, 失败 " << failures.loadRelaxed()
+        << u8", 最终有效点 " << tree.validnum() << " / " << live << Qt::endl;
+    return failures.loadRelaxed();
+}
+
+/**
+ * @brief 一个写线程的修改计划 - 每轮插入一批点、删除其中约1/10的已有点，每5轮删除一个包围盒
+ */
+struct WRITER_PLAN {
+    QVector<QVector<PointType>> addBatches;
+    QVector<QVector<PointType>> removeBatches;
+    QVector<QVector<Tree::BoxType>> removeBoxes;
+};
+
+/**
+ * @brief 生成writers个写线程的计划，第w个写线程只在x方向第w段内修改
+ */
+static QVector<WRITER_PLAN> makeWriterPlans(const STRESS_OPTIONS& options, int writers)
+{
+    QVector<WRITER_PLAN> plans(writers);
+    const double slab = 2.0 * options.extent / writers;
+    for (int w = 0; w < writers; w++) {
+        QRandomGenerator rng(quint32(77 + w));
+        const double xMin = -options.extent + w * slab;
+        const double xMax = xMin + slab;
+        QVector<PointType> owned;
+        for (int round = 0; round < options.operations; round++) {
+            QVector<PointType> addBatch;
+            for (int i = 0; i < options.batch; i++) {
+                PointType point = randomPoint(rng, options.extent, w * 10000000 + round * options.batch + i);
+                point.x = xMin + rng.bounded(slab);
+                addBatch.append(point);
+                owned.append(point);
+            }
+            QVector<PointType> removeBatch;
+            for (int i = 0; i < options.batch / 10; i++) removeBatch.append(owned[rng.bounded(owned.size())]);
+            QVector<Tree::BoxType> boxes;
+            if (round % 5 == 4) {
+                // 包围盒沿x方向裁剪到本段内
+                const PointType center = randomPoint(rng, options.extent);
+                const double cx = xMin + rng.bounded(slab);
+                Tree::BoxType box;
+                box.vertex_min[0] = qMax(xMin, cx - 2.0);
+                box.vertex_max[0] = qMin(xMax, cx + 2.0);
+                box.vertex_min[1] = center.y - 2.0;
+                box.vertex_max[1] = center.y + 2.0;
+                box.vertex_min[2] = center.z - 2.0;
+                box.vertex_max[2] = center.z + 2.0;
+                boxes.append(box);
+            }
+            plans[w].addBatches.append(addBatch);
+            plans[w].removeBatches.append(removeBatch);
+            plans[w].removeBoxes.append(boxes);
+        }
+    }
+    return plans;
+}
+
+static void runWriterPlan(Tree& tree, const WRITER_PLAN& plan)
+{
+    for (int round = 0; round < plan.addBatches.size(); round++) {
+        QVector<PointType> addBatch = plan.addBatches[round];
+        tree.addPoints(addBatch, false);
+        QVector<PointType> removeBatch = plan.removeBatches[round];
+        if (!removeBatch.isEmpty()) tree.deletePoints(removeBatch);
+        QVector<Tree::BoxType> boxes = plan.removeBoxes[round];
+        if (!boxes.isEmpty()) tree.deletePointBoxes(boxes);
+    }
+}
+
+/**
+ * @brief 按坐标和附加数据排序的树内容，用于比较两棵树
+ */
+static QVector<PointType> sortedContent(const Tree& tree, double extent)
+{
+    Tree::BoxType all;
+    for (int axis = 0; axis < 3; axis++) {
+        all.vertex_min[axis] = -2.0 * extent;
+        all.vertex_max[axis] = 2.0 * extent;
+    }
+    QVector<PointType> points;
+    tree.boxSearch(all, points);
+    std::sort(points.begin(), points.end(), [](const PointType& a, const PointType& b) {
+        if (a.x != b.x) return a.x < b.x;
+        if (a.y != b.y) return a.y < b.y;
+        if (a.z != b.z) return a.z < b.z;
+        return a.data < b.data;
+    });
+    return points;
+}
+
+/**
+ * @brief 多写者分区扩展性测试，返回内容不一致的次数
+ */
+static qint64 runWriterScaling(const STRESS_OPTIONS& options, QTextStream& out)
+{
+    QRandomGenerator rng(1);
+    QVector<PointType> initial;
+    for (int i = 0; i < options.initialPoints; i++) initial.append(randomPoint(rng, options.extent, -1 - i));
+
+    QVector<int> writerCounts;
+    for (int writers = 1; writers < options.writers; writers *= 2) writerCounts.append(writers);
+    writerCounts.append(options.writers);
+
+    out << "partition depth=" << options.partitionDepth << " rounds=" << options.operations
+        << " batch=" << options.batch << " idealThreadCount=" << QThread::idealThreadCount() << Qt::endl;
+    qint64 failures = 0;
+    for (int writers : writerCounts) {
+        const QVector<WRITER_PLAN> plans = makeWriterPlans(options, writers);
+        const double insertedPoints = double(writers) * options.operations * options.batch;
+
+        Tree reference(0.5, 0.6, 0.2);
+        reference.build(initial);
+        QElapsedTimer timer;
+        timer.start();
+        for (const WRITER_PLAN& plan : plans) runWriterPlan(reference, plan);
+        const double serialSeconds = timer.nsecsElapsed() / 1e9;
+
+        Tree tree(0.5, 0.6, 0.2);
+        tree.build(initial);
+        tree.setWriterPartitionDepth(options.partitionDepth);
+        QVector<QThread*> threads;
+        for (const WRITER_PLAN& plan : plans) {
+            threads.append(QThread::create([&tree, &plan]() { runWriterPlan(tree, plan); }));
+        }
+        timer.restart();
+        for (QThread* thread : threads) thread->start();
+        for (QThread* thread : threads) thread->wait();
+        const double concurrentSeconds = timer.nsecsElapsed() / 1e9;
+        qDeleteAll(threads);
+
+        const QVector<PointType> expected = sortedContent(reference, options.extent);
+        const QVector<PointType> actual = sortedContent(tree, options.extent);
+        const bool same = std::equal(expected.begin(), expected.end(), actual.begin(), actual.end(),
+                                     [](const PointType& a, const PointType& b) {
+            return a.x == b.x && a.y == b.y && a.z == b.z && a.data == b.data;
+        });
+        if (!same) failures++;
+        out << "  writers=" << writers
+            << u8" 串行 " << insertedPoints / serialSeconds / 1e3 << " kpts/s"
+            << u8" 并发 " << insertedPoints / concurrentSeconds / 1e3 << " kpts/s"
+            << u8" 加速比 " << serialSeconds / concurrentSeconds
+            << u8" 内容" << (same ? u8"一致" : u8"不一致") << Qt::endl;
+    }
+    return failures;
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ikd_tree_qt_stress");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(u8"ikd-Tree并发压力测试");
+    parser.addHelpOption();
+    const QCommandLineOption modeOption("mode", u8"readers：多读者对单写者；writers：多写者分区扩展性", "mode", "readers");
+    const QCommandLineOption writersOption("writers", u8"writers模式的最大写线程数", "n", "4");
+    const QCommandLineOption depthOption("partition-depth", u8"writers模式的写分区深度", "n", "3");
+    const QCommandLineOption readersOption("readers", u8"查询线程数", "n", "4");
+    const QCommandLineOption pointsOption("points", u8"初始点数", "n", "20000");
+    const QCommandLineOption operationsOption("operations", u8"写操作次数", "n", "400");
+    const QCommandLineOption batchOption("batch", u8"每次写操作插入的点数", "n", "200");
+    const QCommandLineOption kOption("k", u8"近邻数", "n", "5");
+    const QCommandLineOption checkOption("check-every", u8"每隔多少次查询暴力校验一次", "n", "8");
+    const QCommandLineOption baselineOption("baseline-ms", u8"只有查询时的运行时长（毫秒）", "ms", "1000");
+    parser.addOption(modeOption);
+    parser.addOption(writersOption);
+    parser.addOption(depthOption);
+    parser.addOption(readersOption);
+    parser.addOption(pointsOption);
+    parser.addOption(operationsOption);
+    parser.addOption(batchOption);
+    parser.addOption(kOption);
+    parser.addOption(checkOption);
+    parser.addOption(baselineOption);
+    parser.process(app);
+
+    STRESS_OPTIONS options;
+    options.readers = qMax(1, parser.value(readersOption).toInt());
+    options.initialPoints = qMax(1, parser.value(pointsOption).toInt());
+    options.operations = qMax(1, parser.value(operationsOption).toInt());
+    options.batch = qMax(1, parser.value(batchOption).toInt());
+    options.k = qMax(1, parser.value(kOption).toInt());
+    options.checkEvery = qMax(1, parser.value(checkOption).toInt());
+    options.baselineMs = qMax(0, parser.value(baselineOption).toInt());
+    options.writers = qMax(1, parser.value(writersOption).toInt());
+    options.partitionDepth = qMax(0, parser.value(depthOption).toInt());
+
+    QTextStream out(stdout);
+    const bool writerMode = parser.value(modeOption) == "writers";
+    const qint64 failures = writerMode ? runWriterScaling(options, out) : runReaderStress(options, out);
+    out << (failures == 0 ? "PASS" : "FAIL") << Qt::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,24 @@
+QT += core
+QT -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = ikd_tree_qt_stress
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# 包含ikd-Tree库头文件
+INCLUDEPATH += .
+
+# 源文件
+SOURCES += \
+    ikd_tree_qt_stress.cpp
+
+# 头文件
+HEADERS += \
+    ikd_Tree_qt.hpp
+
+# 编译器标志
+QMAKE_CXXFLAGS += -std=c++17
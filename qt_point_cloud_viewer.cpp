@@ -6,6 +6,7 @@
 #include <QtMath>
 #include <QDebug>
 #include <QTime>
+#include <QSet>
 #ifdef _WIN32
 #include <Windows.h>
 #include <gl/GL.h>
@@ -350,7 +351,7 @@ void QtPointCloudViewer::resetCamera()
 QtIkdTreeDemo::QtIkdTreeDemo(
     QWidget *parent)
     : QWidget(parent)
-    , m_kdTree(new KD_TREE<ikdTree_PointType<double>>(0.5, 0.6, 0.2))
+    , m_kdTree(new KD_TREE<ikdTree_PointType<PointId>>(0.5, 0.6, 0.2))
     , m_updateTimer(new QTimer(this))
 {
     resize(1400, 900);
@@ -583,10 +584,11 @@ void QtIkdTreeDemo::generateRandomPoints()
     addLog(QString(QString::fromUtf8("🎲 开始生成 %1 个随机点...")).arg(pointCount));
     
     for (int i = 0; i < pointCount; ++i) {
-        ikdTree_PointType<double> point;
+        ikdTree_PointType<PointId> point;
         point.x = rng->bounded(qint64(-25.0), qint64(25.0));
         point.y = rng->bounded(qint64(-25.0), qint64(25.0));
         point.z = rng->bounded(qint64(-25.0), qint64(25.0));
+        point.data = PointId(i);
         m_originalPoints.append(point);
         
         if (i % 1000 == 0) {
@@ -620,7 +622,8 @@ void QtIkdTreeDemo::buildTree()
     addLog(QString::fromUtf8("🌲 开始构建ikd-Tree..."));
     
     // 创建新的ikd-Tree实例
-    m_kdTree.reset(new KD_TREE<ikdTree_PointType<double>>(0.5, 0.6, 0.2));
+    m_kdTree.reset(new KD_TREE<ikdTree_PointType<PointId>>(0.5, 0.6, 0.2));
+    m_kdTree->setPointIdTracking(true);
 
     // 构建树
     m_kdTree->build(m_originalPoints);
@@ -662,7 +665,7 @@ void QtIkdTreeDemo::performBoxSearch()
     timer.start();
     
     // 执行搜索
-    QVector<ikdTree_PointType<double>> searchResults;
+    QVector<ikdTree_PointType<PointId>> searchResults;
     m_kdTree->boxSearch(box, searchResults);
     
     const auto elapsed = timer.elapsed();
@@ -694,7 +697,7 @@ void QtIkdTreeDemo::performRadiusSearch()
     }
     
     // 设置搜索参数
-    ikdTree_PointType<double> center;
+    ikdTree_PointType<PointId> center;
     center.x = m_radiusCenterX->value();
     center.y = m_radiusCenterY->value();
     center.z = m_radiusCenterZ->value();
@@ -704,7 +707,7 @@ void QtIkdTreeDemo::performRadiusSearch()
     timer.start();
     
     // 执行搜索
-    QVector<ikdTree_PointType<double>> searchResults;
+    QVector<ikdTree_PointType<PointId>> searchResults;
     m_kdTree->radiusSearch(center, static_cast<float>(radius), searchResults);
     
     const auto elapsed = timer.elapsed();
@@ -762,7 +765,7 @@ void QtIkdTreeDemo::addLog(const QString& message)
 }
 
 QtPointCloudViewer::ColoredPointCloud QtIkdTreeDemo::convertToColoredCloud(
-    const QVector<ikdTree_PointType<double>> &points, const QVector3D &color)
+    const QVector<ikdTree_PointType<PointId>> &points, const QVector3D &color)
 {
     QtPointCloudViewer::ColoredPointCloud result;
     result.reserve(points.size());
@@ -785,25 +788,24 @@ void QtIkdTreeDemo::deleteBoxSearchResults()
     QElapsedTimer timer;
     timer.start();
     
-    // 从ikd-Tree中批量删除搜索到的点
-    QVector<ikdTree_PointType<double>> pointsToDelete = m_lastBoxSearchResults;
-    m_kdTree->deletePoints(pointsToDelete);
-    int deletedCount = pointsToDelete.size();
+    // 按点编号从ikd-Tree中批量删除搜索到的点
+    QVector<PointId> idsToDelete;
+    idsToDelete.reserve(m_lastBoxSearchResults.size());
+    for (const auto& point : m_lastBoxSearchResults) {
+        idsToDelete.append(point.data);
+    }
+    QVector<PointId> removedIds;
+    int deletedCount = m_kdTree->deletePointsById(idsToDelete, &removedIds);
     
     const auto elapsed = timer.elapsed();
     
-    // 更新原始点云数据（从中移除已删除的点）
-    for (const auto& pointToDelete : m_lastBoxSearchResults) {
-        for (int i = m_originalPoints.size() - 1; i >= 0; --i) {
-            const auto& originalPoint = m_originalPoints[i];
-            if (qAbs(originalPoint.x - pointToDelete.x) < 1e-6 &&
-                qAbs(originalPoint.y - pointToDelete.y) < 1e-6 &&
-                qAbs(originalPoint.z - pointToDelete.z) < 1e-6) {
-                m_originalPoints.removeAt(i);
-                break;
-            }
-        }
-    }
+    // 更新原始点云数据（只移除树中实际删除的点）
+    const QSet<PointId> deletedIds(removedIds.cbegin(), removedIds.cend());
+    m_originalPoints.erase(std::remove_if(m_originalPoints.begin(), m_originalPoints.end(),
+                                          [&deletedIds](const ikdTree_PointType<PointId>& point) {
+                                              return deletedIds.contains(point.data);
+                                          }),
+                           m_originalPoints.end());
     
     // 更新可视化
     auto updatedCloud = convertToColoredCloud(m_originalPoints, QVector3D(0.5f, 0.5f, 0.5f));
@@ -834,25 +836,24 @@ void QtIkdTreeDemo::deleteRadiusSearchResults()
     QElapsedTimer timer;
     timer.start();
     
-    // 从ikd-Tree中批量删除搜索到的点
-    QVector<ikdTree_PointType<double>> pointsToDelete = m_lastRadiusSearchResults;
-    m_kdTree->deletePoints(pointsToDelete);
-    int deletedCount = pointsToDelete.size();
+    // 按点编号从ikd-Tree中批量删除搜索到的点
+    QVector<PointId> idsToDelete;
+    idsToDelete.reserve(m_lastRadiusSearchResults.size());
+    for (const auto& point : m_lastRadiusSearchResults) {
+        idsToDelete.append(point.data);
+    }
+    QVector<PointId> removedIds;
+    int deletedCount = m_kdTree->deletePointsById(idsToDelete, &removedIds);
     
     const auto elapsed = timer.elapsed();
     
-    // 更新原始点云数据（从中移除已删除的点）
-    for (const auto& pointToDelete : m_lastRadiusSearchResults) {
-        for (int i = m_originalPoints.size() - 1; i >= 0; --i) {
-            const auto& originalPoint = m_originalPoints[i];
-            if (qAbs(originalPoint.x - pointToDelete.x) < 1e-6 &&
-                qAbs(originalPoint.y - pointToDelete.y) < 1e-6 &&
-                qAbs(originalPoint.z - pointToDelete.z) < 1e-6) {
-                m_originalPoints.removeAt(i);
-                break;
-            }
-        }
-    }
+    // 更新原始点云数据（只移除树中实际删除的点）
+    const QSet<PointId> deletedIds(removedIds.cbegin(), removedIds.cend());
+    m_originalPoints.erase(std::remove_if(m_originalPoints.begin(), m_originalPoints.end(),
+                                          [&deletedIds](const ikdTree_PointType<PointId>& point) {
+                                              return deletedIds.contains(point.data);
+                                          }),
+                           m_originalPoints.end());
     
     // 更新可视化
     auto updatedCloud = convertToColoredCloud(m_originalPoints, QVector3D(0.5f, 0.5f, 0.5f));
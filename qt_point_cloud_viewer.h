@@ -223,10 +223,10 @@ private:
     QTextEdit* m_logText;                   ///< 日志文本
     
     // ikd-Tree相关
-    QScopedPointer<KD_TREE<ikdTree_PointType<double>>> m_kdTree;  ///< ikd-Tree实例
-    QVector<ikdTree_PointType<double>> m_originalPoints;          ///< 原始点数据
-    QVector<ikdTree_PointType<double>> m_lastBoxSearchResults;    ///< 最后一次包围盒搜索结果
-    QVector<ikdTree_PointType<double>> m_lastRadiusSearchResults; ///< 最后一次半径搜索结果
+    QScopedPointer<KD_TREE<ikdTree_PointType<PointId>>> m_kdTree;  ///< ikd-Tree实例
+    QVector<ikdTree_PointType<PointId>> m_originalPoints;          ///< 原始点数据
+    QVector<ikdTree_PointType<PointId>> m_lastBoxSearchResults;    ///< 最后一次包围盒搜索结果
+    QVector<ikdTree_PointType<PointId>> m_lastRadiusSearchResults; ///< 最后一次半径搜索结果
 
     QTimer* m_updateTimer;                  ///< 更新定时器
 
@@ -293,7 +293,7 @@ private:
      * @param color 点颜色
      * @return Qt可视化点云数据
      */
-    QtPointCloudViewer::ColoredPointCloud convertToColoredCloud(const QVector<ikdTree_PointType<double>> &points,
+    QtPointCloudViewer::ColoredPointCloud convertToColoredCloud(const QVector<ikdTree_PointType<PointId>> &points,
                                                                 const QVector3D &color = QVector3D(1.0f, 1.0f, 1.0f));
 };
 